@@ -1,6 +1,9 @@
 #include "CalcServer.h"
 
+#include <algorithm>
+#include <cmath>
 #include <exception>
+#include <optional>
 
 namespace calc_server{
 
@@ -12,22 +15,135 @@ namespace calc_server{
         return ans;
     }
 
-    ResultInsertRequest WaitWorkThreadCheckTableNames(int iteration, int id, DatabaseManagements& db){           
-        for(int i = 0; i < iteration; ++i){
-            ResultInsertRequest request_ans = db.GetResultSelectFromID(id);
-            if(request_ans.id_request != -1){
-                return request_ans;
+    //Префикс значения, отправленного в kDelta: пустой параметр означает "не изменился" (NULL в таблице)
+    constexpr char kMarkerSentCell = '=';
+
+    //Максимальное ожидание одного служебного запроса (создание таблиц, списки таблиц и столбцов, коэффициенты)
+    constexpr std::chrono::milliseconds kTimeoutRequest{60000};
+
+    template<typename TypeData>
+    void RegisterCode(std::unordered_map<std::string, std::vector<const TypeData*>>& code_to_data, const TypeData* data, const std::string& table_name){
+        auto& same_code = code_to_data[data->code];
+        same_code.push_back(data);
+
+        if(same_code.size() == 2){
+            logger.log("The code \"" + data->code + "\" is ambiguous, it is also found in the table: " + table_name, Logger::LogLevel::kWarning);
+        }
+    }
+
+    template<typename TypeData>
+    TypeData* FindObject(const std::unordered_map<std::string, std::unordered_map<std::string, TypeData*>>& tables, const std::string& table_name, const std::string& code){
+        auto table = tables.find(table_name);
+        if(table == tables.end()){
+            return nullptr;
+        }
+
+        auto data = table->second.find(code);
+        return (data == table->second.end()) ? nullptr : data->second;
+    }
+
+    BlockWiring CreateBlockWiring(  const std::string& type,
+                                    const MapNameInputSignalToDataPtr& inputs,
+                                    const MapNameTableToValueCoefficientsPtr& coefficients,
+                                    const MapNameTableToValueOutputSignalsPtr& outputs
+    ){
+        BlockWiring wiring;
+        wiring.type = type;
+
+        for(const auto& [code, signal] : inputs){
+            wiring.inputs.push_back(signal);
+        }
+
+        for(const auto& [table_name, table_content] : coefficients){
+            for(const auto& [code, coefficient] : table_content){
+                wiring.coefficients.push_back(coefficient);
+            }
+        }
+
+        for(const auto& [table_name, table_content] : outputs){
+            for(const auto& [code, signal] : table_content){
+                wiring.outputs.push_back(signal);
             }
+        }
 
-            std::this_thread::sleep_for(0.01s);
+        return wiring;
+    }
 
-            #ifdef DEBUG
-                std::cout << "Waiting update" <<std::endl; 
-            #endif
+    //Имя блока для меток метрик, не зависящее от порядка блоков: поле "Name" модели,
+    //иначе таблица и код первого выходного сигнала, иначе файл модели и номер блока в нём
+    std::string GetBlockName(const json& block, const fs_path& file_model, size_t index_block){
+        if(auto name = block.find("Name"); name != block.end() && name->is_string() && !name->get<std::string>().empty()){
+            return name->get<std::string>();
+        }
+
+        if(auto outputs = block.find("Outputs"); outputs != block.end() && outputs->is_array() && !outputs->empty()){
+            const json& output = outputs->front();
+            auto table_name = output.find("table_name");
+            auto code = output.find("code");
+
+            if(table_name != output.end() && code != output.end() && table_name->is_string() && code->is_string()){
+                return table_name->get<std::string>() + "." + code->get<std::string>();
+            }
+        }
+
+        return file_model.filename().string() + "#" + std::to_string(index_block);
+    }
+
+    template<typename TypeData>
+    bool IsSameObjects(std::vector<const TypeData*> first, std::vector<const TypeData*> second){
+        std::sort(first.begin(), first.end());
+        std::sort(second.begin(), second.end());
+        return first == second;
+    }
+
+    //Освобождает объекты хранилища, которых нет в used. Возвращает число освобождённых
+    template<typename TypeData>
+    size_t ReleaseUnused(SignalStore<TypeData>& store, const std::unordered_set<const TypeData*>& used){
+        std::vector<SignalHandle> unused;
+
+        store.ForEach([&used, &unused](SignalHandle handle, TypeData& data){
+            if(!used.contains(&data)){
+                unused.push_back(handle);
+            }
+        });
+
+        for(SignalHandle handle : unused){
+            store.Release(handle);
+        }
+
+        return unused.size();
+    }
+
+    //Новый каталог во временном каталоге системы, пустой путь - ошибка
+    fs_path CreateShadowDirectory(){
+        std::error_code error;
+        fs_path temp_directory = std::filesystem::temp_directory_path(error);
+        if(error){
+            return {};
+        }
+
+        auto stamp = std::chrono::system_clock::now().time_since_epoch().count();
 
+        for(size_t attempt = 0; attempt < 100; ++attempt){
+            fs_path path = temp_directory / ("calc_server_plugins_" + std::to_string(stamp) + "_" + std::to_string(attempt));
+
+            if(std::filesystem::create_directory(path, error)){
+                return path;
+            }
+
+            if(error){
+                return {};
+            }
         }
 
-        return {};           
+        return {};
+    }
+
+    //Блок связан с теми же объектами, порядок не важен
+    bool IsSameWiring(const BlockWiring& first, const BlockWiring& second){
+        return  IsSameObjects(first.inputs, second.inputs) &&
+                IsSameObjects(first.coefficients, second.coefficients) &&
+                IsSameObjects(first.outputs, second.outputs);
     }
 
     CalcServer::CalcServer(){
@@ -40,9 +156,39 @@ namespace calc_server{
         }
     }
 
+    std::unique_ptr<IDatabaseClient> CheckDatabaseClient(std::unique_ptr<IDatabaseClient>&& db_client){
+        if(db_client == nullptr){
+            throw std::logic_error("The database client is not set");
+        }
+
+        return std::move(db_client);
+    }
+
+    CalcServer::CalcServer(std::unique_ptr<IDatabaseClient> db_client)
+        :   db_client_(CheckDatabaseClient(std::move(db_client)))
+    {
+        if(!ConnectDatabase(name_db_out_)){
+           throw std::logic_error("Check the errors above. The connection cannot be created.");
+        }
+
+        if(!ConnectDatabase(name_db_coefficient_)){
+            throw std::logic_error("Check the errors above. The connection cannot be created.");
+        }
+    }
+
     CalcServer::~CalcServer(){
+        StopRealTime();
+        StopReload();
+        StopCoefficientRefresher();
+
+        if(!FlushOutputSignals()){
+            logger.log("Not all output signals were written to the database when the server was stopped", Logger::LogLevel::kCritical);
+        }
+
+        output_pipeline_.reset();
+
         for(int i = 0; i < 3600; ++i){
-            if(db_manager_.AreRequestsInProgress()){
+            if(request_tracker_.AreRequestsInProgress()){
                 std::cout << "Wait" << std::endl;
                 std::this_thread::sleep_for(1s);
             }else{
@@ -50,6 +196,10 @@ namespace calc_server{
             }
         }
 
+        //Копии плагинов удаляются после выгрузки: блоки удаляются до своих плагинов
+        created_blocks_.clear();
+        upload_library_.clear();
+        RemoveShadowDirectories();
     }
 
     void CalcServer::CreateBlocksFromJSON(const fs_path& path){
@@ -59,20 +209,155 @@ namespace calc_server{
 
         size_t size_before = created_blocks_.size();
 
-        std::vector<json> load_jsons;
+        std::vector<fs_path> files_models;
 
         try{
-            load_jsons = LoadAllFiles<json>(path, ".json");
-            calc_server::logger.log("Load jsons: " +  std::to_string(load_jsons.size()), Logger::LogLevel::kInfo);
-            
+            files_models = ListModelFiles(path);
         }catch(const std::exception& e){
             logger.log(e.what(), Logger::LogLevel::kError);
             return;
         }
 
-        for (const auto &load_json_model : load_jsons){
+        //Разбор файлов и вызовы Create выполняются параллельно, регистрация сигналов - последовательно
+        //в порядке файлов, поэтому порядок блоков и сигналов не зависит от числа потоков
+        std::unique_ptr<WorkStealingPool> load_pool;
+        if(count_load_threads_ > 1 && files_models.size() > 1){
+            load_pool = std::make_unique<WorkStealingPool>(count_load_threads_);
+        }
+
+        auto run_tasks = [&load_pool](size_t count, const std::function<void(size_t)>& task){
+            RunLoadTasks(load_pool.get(), count, task);
+        };
+
+        std::vector<json> load_jsons;
+        std::vector<std::string> errors_load(files_models.size());
+
+        bool use_snapshot = !path_model_snapshot_.empty();
+        uint64_t key_models = 0;
+
+        //Ключ снимка - имена и содержимое файлов моделей в порядке загрузки
+        if(use_snapshot){
+            std::vector<uint64_t> hashes_files(files_models.size());
+
+            run_tasks(files_models.size(), [&](size_t index){
+                KeyHasher key_file;
+                if(key_file.AddFileContent(files_models[index])){
+                    hashes_files[index] = key_file.Get();
+                }
+            });
+
+            KeyHasher key;
+            key.Add(static_cast<uint64_t>(files_models.size()));
+            for(size_t index = 0; index < files_models.size(); ++index){
+                key.Add(files_models[index].filename().string());
+                key.Add(hashes_files[index]);
+            }
+            key_models = key.Get();
+        }
+
+        if(!use_snapshot || !TakeModelsFromSnapshot(key_models, load_jsons)){
+            load_jsons.assign(files_models.size(), json());
+
+            run_tasks(files_models.size(), [&](size_t index){
+                try{
+                    load_jsons[index] = ParseModelFile(files_models[index]);
+                }catch(const std::exception& e){
+                    errors_load[index] = files_models[index].string() + ": " + e.what();
+                }
+            });
+        }
+
+        size_t count_loaded = 0;
+        for(const auto& error : errors_load){
+            if(error.empty()){
+                ++count_loaded;
+            }else{
+                logger.log(error, Logger::LogLevel::kError);
+            }
+        }
+        calc_server::logger.log("Load jsons: " +  std::to_string(count_loaded), Logger::LogLevel::kInfo);
+
+        if(use_snapshot){
+            //Ошибка разбора не сохраняется в снимок, иначе она не попадёт в лог при следующем запуске
+            if(count_loaded != files_models.size()){
+                model_snapshot_complete_ = false;
+            }
+
+            json entry = json::object();
+            entry["key"] = key_models;
+            entry["files"] = load_jsons;
+            model_snapshot_update_["models"].push_back(std::move(entry));
+
+            ++count_model_loads_;
+        }
+
+        Registration registration{maps_};
+        std::vector<PendingBlock> pending_blocks;
+        RegisterModelBlocks(files_models, load_jsons, ComputeBlockKeys(files_models, load_jsons, load_pool.get()), registration, nullptr, nullptr, pending_blocks);
+        CreatePendingBlocks(pending_blocks, load_pool.get(), created_blocks_, blocks_wiring_);
+
+        model_directories_.push_back(path);
+
+        calc_server::logger.log("Created blocks: " + std::to_string(created_blocks_.size() - size_before), Logger::LogLevel::kInfo);
+
+        BuildInputSlots();
+    }
+
+    void CalcServer::RunLoadTasks(WorkStealingPool* pool, size_t count, const std::function<void(size_t)>& task){
+        if(pool == nullptr){
+            for(size_t index = 0; index < count; ++index){
+                task(index);
+            }
+        }else{
+            pool->ForEach(count, task);
+        }
+    }
+
+    std::vector<std::vector<uint64_t>> CalcServer::ComputeBlockKeys(const std::vector<fs_path>& files_models, const std::vector<json>& load_jsons, WorkStealingPool* pool){
+        std::vector<std::vector<uint64_t>> keys(load_jsons.size());
+
+        //Ключ не зависит от положения блока в файле, чтобы вставка блока не меняла ключи следующих
+        RunLoadTasks(pool, load_jsons.size(), [&](size_t index_file){
+            if(!load_jsons[index_file].is_array()){
+                return;
+            }
+
+            std::string name_file = files_models[index_file].string();
+
+            for(const auto& element : load_jsons[index_file]){
+                KeyHasher key;
+                key.Add(name_file);
+                key.Add(element.dump());
+                keys[index_file].push_back(key.Get());
+            }
+        });
+
+        return keys;
+    }
+
+    size_t CalcServer::RegisterModelBlocks( const std::vector<fs_path>& files_models,
+                                            const std::vector<json>& load_jsons,
+                                            const std::vector<std::vector<uint64_t>>& keys_blocks,
+                                            Registration& registration,
+                                            std::unordered_map<uint64_t, std::vector<size_t>>* reusable_blocks,
+                                            std::unordered_map<std::string, DynamicLibrary>* staged_libraries,
+                                            std::vector<PendingBlock>& pending_blocks
+    ){
+        size_t count_errors = 0;
+
+        auto is_staged = [staged_libraries](const std::string& type){
+            return staged_libraries != nullptr && staged_libraries->count(type) > 0;
+        };
+
+        for (size_t index_file = 0; index_file < load_jsons.size(); ++index_file){
+            const auto& load_json_model = load_jsons[index_file];
+            size_t index_block = 0;
+
             try{
                 for (const auto &elem_array_json : load_json_model){
+                    uint64_t key_block = (index_block < keys_blocks[index_file].size()) ? keys_blocks[index_file][index_block] : 0;
+                    ++index_block;
+
                     std::string type_dll = "";
                     MapNameInputSignalToDataPtr signals_input_block;
                     MapNameTableToValueCoefficientsPtr coefficients_block;
@@ -81,8 +366,9 @@ namespace calc_server{
                     if (auto result_find = elem_array_json.find("Type"); result_find != elem_array_json.end()){
                         type_dll = *result_find;
 
-                        if (upload_library_.count(type_dll) == 0){
+                        if (upload_library_.count(type_dll) == 0 && builtin_block_types_.count(type_dll) == 0 && !is_staged(type_dll)){
                             calc_server::logger.log("The DLL file with the \"Type\" field: " + type_dll + " was not found", Logger::LogLevel::kError);
+                            ++count_errors;
                             continue;
                         }
                     }else{
@@ -90,41 +376,150 @@ namespace calc_server{
                     }
 
                     if (auto result_find = elem_array_json.find("Inputs"); result_find != elem_array_json.end()){
-                        signals_input_block = LoadSignalInput(*result_find);
+                        signals_input_block = LoadSignalInput(*result_find, registration);
                     }else{
                         continue;
                     }
 
                     if (auto result_find = elem_array_json.find("Coefficients"); result_find != elem_array_json.end()){
-                        coefficients_block = LoadSignalCoefficient(*result_find);
+                        coefficients_block = LoadSignalCoefficient(*result_find, registration);
                     }else{
                         continue;
                     }
 
                     if (auto result_find = elem_array_json.find("Outputs"); result_find != elem_array_json.end()){
-                        signals_output_block = LoadSignalOutput(*result_find);
+                        signals_output_block = LoadSignalOutput(*result_find, registration);
                     }else{
                         continue;
                     }
 
-                    created_blocks_.push_back(
-                        {upload_library_.find(type_dll)->second.GetFunction<CreateFunction>("Create")(
-                            std::move(signals_input_block),
-                            std::move(coefficients_block),
-                            std::move(signals_output_block))}
-                    );
+                    PendingBlock pending;
+                    pending.wiring = CreateBlockWiring(type_dll, signals_input_block, coefficients_block, signals_output_block);
+                    pending.wiring.source_key = key_block;
+                    pending.wiring.name = GetBlockName(elem_array_json, files_models[index_file], index_block - 1);
+
+                    if (auto result_find = elem_array_json.find("AlwaysProcess"); result_find != elem_array_json.end() && result_find->is_boolean()){
+                        pending.wiring.always_process = result_find->get<bool>();
+                    }
+
+                    if(auto builtin = builtin_block_types_.find(type_dll); builtin != builtin_block_types_.end()){
+                        pending.create_block = builtin->second;
+                    }else if(is_staged(type_dll)){
+                        pending.create_block = staged_libraries->find(type_dll)->second.GetFunction<CreateFunction>("Create");
+                    }else{
+                        pending.create_block = upload_library_.find(type_dll)->second.GetFunction<CreateFunction>("Create");
+                    }
+
+                    //Описание блока и его плагин не изменились - блок остаётся со своим состоянием
+                    if(reusable_blocks != nullptr && !is_staged(type_dll)){
+                        if(auto reusable = reusable_blocks->find(key_block); reusable != reusable_blocks->end() && !reusable->second.empty()){
+                            pending.index_reused = reusable->second.back();
+                            reusable->second.pop_back();
+                        }
+                    }
+
+                    pending.signals_input = std::move(signals_input_block);
+                    pending.coefficients = std::move(coefficients_block);
+                    pending.signals_output = std::move(signals_output_block);
 
-                    #ifdef DEBUG
-                        calc_server::logger.log("Create blocks with type: " + type_dll);
-                    #endif
+                    pending_blocks.push_back(std::move(pending));
                 }
             }catch(const std::exception& e){
-                logger.log(e.what(), Logger::LogLevel::kError);
+                logger.log(files_models[index_file].string() + ": " + e.what(), Logger::LogLevel::kError);
+                ++count_errors;
             }
         }
 
-        calc_server::logger.log("Created blocks: " + std::to_string(created_blocks_.size() - size_before), Logger::LogLevel::kInfo);
-         
+        return count_errors;
+    }
+
+    size_t CalcServer::CreatePendingBlocks( std::vector<PendingBlock>& pending_blocks,
+                                            WorkStealingPool* pool,
+                                            std::vector<std::unique_ptr<ICalcElement>>& blocks,
+                                            std::vector<BlockWiring>& blocks_wiring,
+                                            std::vector<size_t>* index_reused
+    ){
+        std::vector<std::unique_ptr<ICalcElement>> created(pending_blocks.size());
+        std::vector<std::string> errors_create(pending_blocks.size());
+
+        RunLoadTasks(pool, pending_blocks.size(), [&](size_t index){
+            PendingBlock& pending = pending_blocks[index];
+
+            if(pending.index_reused != PendingBlock::kNewBlock){
+                return;
+            }
+
+            try{
+                created[index] = pending.create_block(
+                    std::move(pending.signals_input),
+                    std::move(pending.coefficients),
+                    std::move(pending.signals_output)
+                );
+            }catch(const std::exception& e){
+                errors_create[index] = e.what();
+            }
+        });
+
+        size_t count_errors = 0;
+
+        for(size_t index = 0; index < pending_blocks.size(); ++index){
+            if(!errors_create[index].empty()){
+                logger.log(errors_create[index], Logger::LogLevel::kError);
+                ++count_errors;
+                continue;
+            }
+
+            blocks.push_back(std::move(created[index]));
+            blocks_wiring.push_back(std::move(pending_blocks[index].wiring));
+
+            if(index_reused != nullptr){
+                index_reused->push_back(pending_blocks[index].index_reused);
+            }
+
+            #ifdef DEBUG
+                calc_server::logger.log("Create blocks with type: " + blocks_wiring.back().type);
+            #endif
+        }
+
+        return count_errors;
+    }
+
+    std::vector<fs_path> CalcServer::ListModelFiles(const fs_path& path){
+        std::vector<fs_path> files;
+
+        for(const auto& entry : std::filesystem::directory_iterator(path)){
+            if(entry.is_regular_file() && entry.path().extension() == ".json"){
+                files.push_back(entry.path());
+            }
+        }
+
+        //Порядок обхода каталога не определён, сортировка делает порядок блоков одинаковым на любой ФС
+        std::sort(files.begin(), files.end());
+
+        return files;
+    }
+
+    json CalcServer::ParseModelFile(const fs_path& path){
+        MappedFile file;
+
+        if(!file.Open(path)){
+            throw std::runtime_error("It is not possible to open the file");
+        }
+
+        std::string_view content = file.GetContent();
+        return json::parse(content.begin(), content.end());
+    }
+
+    void CalcServer::SetCountLoadThreads(size_t count_threads){
+        count_load_threads_ = std::max<size_t>(count_threads, 1);
+    }
+
+    void CalcServer::RegisterBlockType(const std::string& type, CreateFunction create_block){
+        if(create_block == nullptr){
+            throw std::logic_error("Empty create function for the block type: " + type);
+        }
+
+        builtin_block_types_[type] = create_block;
     }
 
     void CalcServer::LoadDLLFunctions(const fs_path& path){
@@ -133,6 +528,7 @@ namespace calc_server{
         #endif
 
         size_t size_before = upload_library_.size();
+        dll_directories_.push_back(path);
 
         for(auto& dll : LoadAllFiles<DynamicLibrary>(path, ".dll")){
             try{ 
@@ -141,6 +537,10 @@ namespace calc_server{
                     logger.log("Two files were found : ( " + dll.GetFileName() + " and " + type_dll_find->second.GetFileName() +  ") with the type : " + type_dll, Logger::LogLevel::kWarning);
                     continue;
                 }
+                KeyHasher stamp;
+                (void)stamp.AddFileStamp(path / fs_path(dll.GetFileName()).filename());
+                library_stamps_[type_dll] = stamp.Get();
+
                 upload_library_.insert({type_dll, std::move(dll)});
             }catch(const std::exception& e){
                 logger.log(e.what(), Logger::LogLevel::kError);
@@ -150,137 +550,585 @@ namespace calc_server{
         calc_server::logger.log("Loaded DLL files: " + std::to_string(upload_library_.size() - size_before)); 
     }
 
-    const SignalInput* CalcServer::CreateSignalInput(const json& data_signal){
-        std::string code_sig = "";
-        std::string kks_sig = "";
+    bool CalcServer::RequestReload(){
+        std::lock_guard lock(mutex_reload_);
 
-        if(auto code = data_signal.find("code"); code != data_signal.end() && (*code != "")){
-            code_sig = *code;
-        }else{
-            throw std::logic_error("The \"Code\" field was not found. The signal cannot be created");
+        ReloadState state = reload_state_.load(std::memory_order_acquire);
+        if(state == ReloadState::kPreparing || state == ReloadState::kReady){
+            return false;
         }
 
-        if(auto kks = data_signal.find("KKS"); kks != data_signal.end() && (*kks != "")){
-            kks_sig = *kks;
-        }else{
-            kks_sig = "KKS_" + code_sig;
-            logger.log("The \"KKS\" field was not found. Assigned the values \"KKS_\" + Code: " + kks_sig, Logger::LogLevel::kDebug);
+        if(model_directories_.empty()){
+            logger.log("There are no models to reload, CreateBlocksFromJSON was not called", Logger::LogLevel::kWarning);
+            return false;
         }
 
-        SignalInput* sig_inp = &signals_input_[code_sig];
+        //Поток предыдущей неудачной перезагрузки
+        if(reload_thread_.joinable()){
+            reload_thread_.join();
+        }
 
-        if(sig_inp->code == ""){
+        //Объекты, зарегистрированные неудачной перезагрузкой, не попали в карты текущего набора
+        if(state == ReloadState::kFailed){
+            prepared_reload_.reset();
+            (void)ReleaseUnusedSignals();
+        }
 
-            sig_inp->code = std::move(code_sig);
-            sig_inp->kks = std::move(kks_sig);
+        //Поток работает только со своим набором, указатель prepared_reload_ меняется под mutex_reload_
+        prepared_reload_ = std::make_unique<PreparedReload>();
+        reload_state_.store(ReloadState::kPreparing, std::memory_order_release);
 
-            if(auto type = data_signal.find("type"); type != data_signal.end() && (*type != "")){
-                sig_inp->type = static_cast<SignalInput::TypeSignals>((*type).dump()[1]);
-            }else{
-                throw std::logic_error("Invalid value of the \"Type\" field");
-            }    
+        reload_thread_ = std::thread([this, prepared_reload = prepared_reload_.get()](){
+            auto start_reload = std::chrono::steady_clock::now();
+            bool prepared = false;
 
-            if(sig_inp->type == SignalInput::TypeSignals::kTS_int){
-                sig_inp->value = 0;
-            }else if(sig_inp->type == SignalInput::TypeSignals::kTS_double){
-                sig_inp->value = 0.0;
-            }else if(sig_inp->type == SignalInput::TypeSignals::kTS_string){
-                sig_inp->value = "";
+            try{
+                prepared = PrepareReload(*prepared_reload);
+            }catch(const std::exception& e){
+                logger.log(std::string("Reload of models: ") + e.what(), Logger::LogLevel::kError);
             }
-        }
 
-        update_value_[sig_inp->kks].insert(sig_inp);
+            if(!prepared){
+                //Блоки и плагины неудачного набора освобождаются сразу, сам объект удаляет следующий RequestReload
+                fs_path shadow_directory = std::move(prepared_reload->shadow_directory);
+                *prepared_reload = PreparedReload{};
 
-        return sig_inp;
+                std::error_code error;
+                std::filesystem::remove_all(shadow_directory, error);
+                logger.log("Reload of models failed, the calculation continues with the current blocks", Logger::LogLevel::kError);
+                reload_state_.store(ReloadState::kFailed, std::memory_order_release);
+                return;
+            }
+
+            logger.LogLazy(Logger::LogLevel::kInfo, [start_reload](){
+                return "Reload of models prepared in " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_reload).count()) + " ms";
+            });
+            reload_state_.store(ReloadState::kReady, std::memory_order_release);
+        });
+
+        return true;
     }
 
-    const SignalOutput* CalcServer::GetSignalOutput(const std::string& code, const std::string& table_name) const{
+    void CalcServer::StopReload(){
+        std::lock_guard lock(mutex_reload_);
 
-        if(table_name == ""){
-            for(const auto& [current_table_name, current_table_content]: signals_output_){
-                auto result = SearchInTable(current_table_content, code);
-                if(result != nullptr){
-                    return result;
-                }
-            }
-        }else{
-            auto iterator_pointing_to_table = signals_output_.find(table_name);
+        if(reload_thread_.joinable()){
+            reload_thread_.join();
+        }
 
-            if(iterator_pointing_to_table != signals_output_.end()){
-                return SearchInTable(iterator_pointing_to_table->second, code);
-            }
+        //Набор, не успевший подставиться, выгружает свои плагины, их копии удаляются
+        if(prepared_reload_ != nullptr){
+            fs_path shadow_directory = std::move(prepared_reload_->shadow_directory);
+            prepared_reload_.reset();
+
+            shadow_directories_.push_back(std::move(shadow_directory));
+            RemoveShadowDirectories();
         }
-        
-        return nullptr;
+
+        reload_state_.store(ReloadState::kIdle, std::memory_order_release);
     }
-    
-    const Coefficient* CalcServer::GetCoefficient(const std::string& code, const std::string& table_name) const{
 
-        if(table_name == ""){
-            for(const auto& [current_table_name, current_table_content]: coefficients_){
-                auto result = SearchInTable(current_table_content, code);
-                if(result != nullptr){
-                    return result;
-                }
+    size_t CalcServer::ReleaseUnusedSignals(){
+        std::unordered_set<const SignalInput*> used_inputs;
+        for(const auto& [code, signal] : maps_.signals_input){
+            used_inputs.insert(signal);
+        }
+
+        std::unordered_set<const Coefficient*> used_coefficients;
+        for(const auto& [table_name, content] : maps_.coefficients){
+            for(const auto& [code, coefficient] : content){
+                used_coefficients.insert(coefficient);
             }
-        }else{
-            auto iterator_pointing_to_table = coefficients_.find(table_name);
+        }
 
-            if(iterator_pointing_to_table != coefficients_.end()){
-                return SearchInTable(iterator_pointing_to_table->second, code);
+        std::unordered_set<const SignalOutput*> used_outputs;
+        for(const auto& [table_name, content] : maps_.signals_output){
+            for(const auto& [code, signal] : content){
+                used_outputs.insert(signal);
             }
         }
 
-        return nullptr; 
+        return  ReleaseUnused(store_signals_input_, used_inputs) +
+                ReleaseUnused(store_coefficients_, used_coefficients) +
+                ReleaseUnused(store_signals_output_, used_outputs);
     }
 
-    const SignalInput* CalcServer::GetSignalInput(const std::string& code) const{
-        if(signals_input_.count(code) == 0){
-            return nullptr;
+    bool CalcServer::StageLibraries(PreparedReload& prepared){
+        //LoadLibrary (и dlopen для того же файла) по уже загруженному пути возвращает старый модуль,
+        //поэтому изменённые плагины копируются в новый каталог и загружаются оттуда
+        prepared.shadow_directory = CreateShadowDirectory();
+        if(prepared.shadow_directory.empty()){
+            logger.log("Reload of plugins. It is not possible to create a directory for copies of plugins", Logger::LogLevel::kError);
+            return false;
         }
 
-        return &signals_input_.at(code);
-    }
+        //Неизменённый плагин совпадает по отметке с загруженным и не загружается повторно
+        std::set<uint64_t> loaded_stamps;
+        for(const auto& [type_dll, stamp] : library_stamps_){
+            loaded_stamps.insert(stamp);
+        }
 
-    MapNameTableToValueCoefficientsPtr CalcServer::CreateCoefficients(const json& data_signal){
-        MapNameTableToValueCoefficientsPtr coefficients;
-        std::string table_name;
+        std::set<std::string> found_types;
 
-        if(auto iter_table_name = data_signal.find("table_name"); iter_table_name == data_signal.end()){
-            throw std::logic_error("Empty \"Coefficients\" object was found");
-        }else{
-            table_name = *iter_table_name;
-        }
+        for(size_t index_directory = 0; index_directory < dll_directories_.size(); ++index_directory){
+            const fs_path& directory = dll_directories_[index_directory];
+            fs_path shadow = prepared.shadow_directory / std::to_string(index_directory);
+            std::unordered_map<std::string, uint64_t> file_stamps;
+            std::error_code error;
 
-        auto iter_code_signals = data_signal.find("code_signals");
-        if(data_signal.find("code_signals") == data_signal.end()){
-            throw std::logic_error("Empty \"Coefficients\" object was found");
-        }
+            for(const auto& entry : std::filesystem::directory_iterator(directory, error)){
+                if(!entry.is_regular_file() || entry.path().extension() != ".dll"){
+                    continue;
+                }
 
-        for(const auto& code_and_row_data : *iter_code_signals){
-            auto code = code_and_row_data.find("code");
+                KeyHasher stamp;
+                if(!stamp.AddFileStamp(entry.path()) || loaded_stamps.contains(stamp.Get())){
+                    continue;
+                }
 
-            if( code == code_and_row_data.end()){
-                throw std::logic_error("Empty \"code\" field when parsing " + table_name);
-            }
+                std::filesystem::create_directories(shadow, error);
+                if(!error){
+                    std::filesystem::copy_file(entry.path(), shadow / entry.path().filename(), error);
+                }
 
-            Coefficient* coef_for_insert = &coefficients_[table_name][*code];
-            coef_for_insert->code = *code;
+                if(error){
+                    logger.log("Reload of plugins. It is not possible to copy " + entry.path().string() + ": " + error.message(), Logger::LogLevel::kError);
+                    return false;
+                }
 
-            for(const auto& row_data : *code_and_row_data.find("row")){
-                coef_for_insert->data_row[row_data];
+                file_stamps[entry.path().filename().string()] = stamp.Get();
             }
 
-            coefficients[table_name][*code] = coef_for_insert;
-        }
+            if(file_stamps.empty()){
+                continue;
+            }
 
-        return coefficients;
-    }
+            for(auto& dll : LoadAllFiles<DynamicLibrary>(shadow, ".dll")){
+                try{
+                    std::string type_dll = dll.GetTypeDLL();
+                    std::string file_name = fs_path(dll.GetFileName()).filename().string();
 
-    SignalOutput* CalcServer::CreateSignalOutput(const json& data_signal){
-        std::string code_str;
-        std::string table_name_str;
-        std::string table_col_str;
+                    //Как в LoadDLLFunctions: из нескольких файлов одного типа берётся первый
+                    if(!found_types.insert(type_dll).second){
+                        continue;
+                    }
+
+                    if(auto loaded = upload_library_.find(type_dll); loaded != upload_library_.end() && fs_path(loaded->second.GetFileName()).filename() != file_name){
+                        logger.log("Two files were found : ( " + file_name + " and " + loaded->second.GetFileName() +  ") with the type : " + type_dll, Logger::LogLevel::kWarning);
+                        continue;
+                    }
+
+                    prepared.library_stamps[type_dll] = file_stamps[file_name];
+                    prepared.libraries.insert({type_dll, std::move(dll)});
+                }catch(const std::exception& e){
+                    logger.log(e.what(), Logger::LogLevel::kError);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void CalcServer::RemoveShadowDirectories(){
+        //Каталог с загруженной DLL Windows удалить не даёт, попытка повторяется после выгрузки плагина
+        std::erase_if(shadow_directories_, [](const fs_path& directory){
+            if(directory.empty()){
+                return true;
+            }
+
+            std::error_code error;
+            std::filesystem::remove_all(directory, error);
+            return !error;
+        });
+    }
+
+    bool CalcServer::PrepareReload(PreparedReload& prepared){
+        if(!StageLibraries(prepared)){
+            return false;
+        }
+
+        std::vector<fs_path> files_models;
+        for(const auto& directory : model_directories_){
+            auto files = ListModelFiles(directory);
+            files_models.insert(files_models.end(), files.begin(), files.end());
+        }
+
+        std::unique_ptr<WorkStealingPool> load_pool;
+        if(count_load_threads_ > 1 && files_models.size() > 1){
+            load_pool = std::make_unique<WorkStealingPool>(count_load_threads_);
+        }
+
+        std::vector<json> load_jsons(files_models.size());
+        std::vector<std::string> errors_load(files_models.size());
+
+        RunLoadTasks(load_pool.get(), files_models.size(), [&](size_t index){
+            try{
+                load_jsons[index] = ParseModelFile(files_models[index]);
+            }catch(const std::exception& e){
+                errors_load[index] = files_models[index].string() + ": " + e.what();
+            }
+        });
+
+        //Файл с ошибкой не подставляется частично: его блоки пропали бы из расчёта
+        bool parsed = true;
+        for(const auto& error : errors_load){
+            if(!error.empty()){
+                logger.log(error, Logger::LogLevel::kError);
+                parsed = false;
+            }
+        }
+
+        if(!parsed){
+            return false;
+        }
+
+        //Одинаковые блоки одного файла переносятся по порядку
+        std::unordered_map<uint64_t, std::vector<size_t>> reusable_blocks;
+        for(size_t block = blocks_wiring_.size(); block-- > 0;){
+            reusable_blocks[blocks_wiring_[block].source_key].push_back(block);
+        }
+
+        Registration registration{prepared.maps, &maps_};
+        std::vector<PendingBlock> pending_blocks;
+
+        if(RegisterModelBlocks(files_models, load_jsons, ComputeBlockKeys(files_models, load_jsons, load_pool.get()), registration, &reusable_blocks, &prepared.libraries, pending_blocks) != 0){
+            return false;
+        }
+
+        //Если сигнал, общий с другим блоком, создан заново, блок тоже создаётся заново
+        for(auto& pending : pending_blocks){
+            if(pending.index_reused != PendingBlock::kNewBlock && !IsSameWiring(pending.wiring, blocks_wiring_[pending.index_reused])){
+                pending.index_reused = PendingBlock::kNewBlock;
+            }
+        }
+
+        if(CreatePendingBlocks(pending_blocks, load_pool.get(), prepared.blocks, prepared.blocks_wiring, &prepared.index_reused) != 0){
+            return false;
+        }
+
+        prepared.count_created = std::count(prepared.index_reused.begin(), prepared.index_reused.end(), PendingBlock::kNewBlock);
+
+        if(prepared.blocks.empty()){
+            logger.log("Reload of models. There are no calculation blocks created", Logger::LogLevel::kError);
+            return false;
+        }
+
+        return PrepareReloadTables(prepared);
+    }
+
+    bool CalcServer::PrepareReloadTables(PreparedReload& prepared){
+        //Столбцы сигналов текущего набора уже есть, их значения в фоне не читаются
+        MapNameTableToValueOutputSignals new_outputs;
+        for(const auto& [table_name, content] : prepared.maps.signals_output){
+            for(const auto& [code, signal] : content){
+                if(FindObject(maps_.signals_output, table_name, code) != signal){
+                    new_outputs[table_name][code] = signal;
+                }
+            }
+        }
+
+        if(!new_outputs.empty() && !PreparingOutputTables(new_outputs, prepared.maps, prepared.exist_tables[name_db_out_])){
+            return false;
+        }
+
+        MapNameTableToValueCoefficients new_coefficients;
+        for(const auto& [table_name, content] : prepared.maps.coefficients){
+            for(const auto& [code, coefficient] : content){
+                if(FindObject(maps_.coefficients, table_name, code) != coefficient){
+                    new_coefficients[table_name][code] = coefficient;
+                }
+            }
+        }
+
+        if(new_coefficients.empty()){
+            return true;
+        }
+
+        std::set<std::string>& exist_tables = prepared.exist_tables[name_db_coefficient_];
+
+        if(!UpdateListExistTable(name_db_coefficient_, exist_tables)){
+            logger.log("Reload of models. The list of coefficient tables was not received from the database", Logger::LogLevel::kError);
+            return false;
+        }
+
+        //Значения новых коэффициентов читаются до подстановки, первый шаг нового набора идёт уже с ними
+        std::vector<RequestHandle> requests;
+
+        for(const auto& [table_name, content] : new_coefficients){
+            if(!CheckTableExist(table_name, exist_tables)){
+                logger.log("Coefficients. The table does not exist in the database specified for connection: " + table_name, Logger::LogLevel::kError);
+                return false;
+            }
+
+            auto request_select = request_tracker_.Submit(name_db_coefficient_, GetCoefficientSelect(table_name), {}, Command::kSelect, table_name);
+
+            if(!request_select.IsValid()){
+                logger.log("Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kError);
+                return false;
+            }
+
+            requests.push_back(std::move(request_select));
+            prepared.coefficient_tables.insert(table_name);
+        }
+
+        for(auto& request : requests){
+            auto result_select = request.Wait(kTimeoutRequest);
+
+            if(result_select.id_request == -1){
+                logger.log("Reload of models. Coefficients were not received from the database", Logger::LogLevel::kError);
+                return false;
+            }
+
+            CoefficientSnapshot snapshot;
+            std::string version;
+            ParseCoefficientRows(result_select, new_coefficients[std::string(result_select.name_table)], nullptr, snapshot, version);
+
+            for(auto& update : snapshot){
+                update.target->data_row = std::move(update.data_row);
+            }
+        }
+
+        return true;
+    }
+
+    void CalcServer::ApplyPendingReload(){
+        if(reload_state_.load(std::memory_order_acquire) != ReloadState::kReady){
+            return;
+        }
+
+        std::unique_ptr<PreparedReload> prepared;
+        {
+            std::lock_guard lock(mutex_reload_);
+
+            //StopReload из другого потока мог отменить набор после проверки выше
+            if(reload_state_.load(std::memory_order_acquire) != ReloadState::kReady){
+                return;
+            }
+
+            reload_thread_.join();
+            prepared = std::move(prepared_reload_);
+        }
+
+        //Накопленные строки записываются по раскладке таблиц старого набора
+        if(!FlushOutputSignals()){
+            logger.log("Not all output signals were written to the database before the reload of models", Logger::LogLevel::kError);
+        }
+
+        bool refresher_running = coefficient_refresher_.joinable();
+        StopCoefficientRefresher();
+
+        for(size_t block = 0; block < prepared->blocks.size(); ++block){
+            if(prepared->index_reused[block] != PendingBlock::kNewBlock){
+                prepared->blocks[block] = std::move(created_blocks_[prepared->index_reused[block]]);
+            }
+        }
+
+        size_t count_libraries = prepared->libraries.size();
+
+        //Блоки старого набора удаляются до выгрузки их плагинов
+        created_blocks_ = std::move(prepared->blocks);
+        blocks_wiring_ = std::move(prepared->blocks_wiring);
+        maps_ = std::move(prepared->maps);
+
+        for(auto& [name_connection, exist_tables] : prepared->exist_tables){
+            name_db_to_exist_tables_[name_connection] = std::move(exist_tables);
+        }
+
+        //Сигналы и коэффициенты старого набора, которых нет в новом, больше ни на что не ссылаются:
+        //блоки старого набора удалены, раскладка записи и входные слоты перестраиваются ниже
+        size_t count_released = ReleaseUnusedSignals();
+
+        for(auto& [type_dll, library] : prepared->libraries){
+            upload_library_.erase(type_dll);
+            upload_library_.insert({type_dll, std::move(library)});
+            library_stamps_[type_dll] = prepared->library_stamps[type_dll];
+        }
+
+        //Старые плагины выгружены, их копии можно удалить
+        shadow_directories_.push_back(std::move(prepared->shadow_directory));
+        RemoveShadowDirectories();
+
+        BuildBlockGraph();
+        BuildInputSlots();
+
+        if(metrics_enabled_){
+            RegisterBlockMetrics();
+        }
+
+        {
+            std::lock_guard lock(mutex_output_writer_);
+            output_batcher_.Clear();
+            name_table_to_request_insert_.clear();
+            (void)PreparingRecordRequestOut();
+            steps_since_keyframe_ = 0;
+        }
+
+        //Следующее обновление читает таблицы с новыми коэффициентами целиком: изменения,
+        //пришедшие после чтения в фоне, иначе попали бы только в объекты старого набора
+        for(const auto& table_name : prepared->coefficient_tables){
+            AddCoefficientRequests(table_name);
+            name_table_to_coefficient_version_.erase(table_name);
+        }
+
+        if(refresher_running){
+            StartCoefficientRefresher();
+        }
+
+        logger.log("Models reloaded. Blocks: " + std::to_string(created_blocks_.size()) + ", created: " + std::to_string(prepared->count_created)
+                    + ", plugins replaced: " + std::to_string(count_libraries) + ", signals released: " + std::to_string(count_released), Logger::LogLevel::kInfo);
+
+        reload_state_.store(ReloadState::kIdle, std::memory_order_release);
+    }
+
+    const SignalInput* CalcServer::CreateSignalInput(const json& data_signal, Registration& registration){
+        std::string code_sig = "";
+        std::string kks_sig = "";
+
+        if(auto code = data_signal.find("code"); code != data_signal.end() && (*code != "")){
+            code_sig = *code;
+        }else{
+            throw std::logic_error("The \"Code\" field was not found. The signal cannot be created");
+        }
+
+        if(auto kks = data_signal.find("KKS"); kks != data_signal.end() && (*kks != "")){
+            kks_sig = *kks;
+        }else{
+            kks_sig = "KKS_" + code_sig;
+            logger.log("The \"KKS\" field was not found. Assigned the values \"KKS_\" + Code: " + kks_sig, Logger::LogLevel::kDebug);
+        }
+
+        SignalInput*& sig_inp = registration.maps.signals_input[code_sig];
+
+        if(sig_inp == nullptr && registration.previous != nullptr){
+            //Сигнал текущего набора блоков остаётся, если KKS и тип в модели не изменились
+            if(auto previous = registration.previous->signals_input.find(code_sig); previous != registration.previous->signals_input.end()){
+                auto type = data_signal.find("type");
+                if(previous->second->kks == kks_sig && type != data_signal.end() && (*type != "") && static_cast<SignalInput::TypeSignals>((*type).dump()[1]) == previous->second->type){
+                    sig_inp = previous->second;
+                }
+            }
+        }
+
+        if(sig_inp == nullptr){
+            sig_inp = &store_signals_input_.Get(store_signals_input_.Add());
+        }
+
+        if(sig_inp->code == ""){
+
+            sig_inp->code = std::move(code_sig);
+            sig_inp->kks = std::move(kks_sig);
+
+            if(auto type = data_signal.find("type"); type != data_signal.end() && (*type != "")){
+                sig_inp->type = static_cast<SignalInput::TypeSignals>((*type).dump()[1]);
+            }else{
+                throw std::logic_error("Invalid value of the \"Type\" field");
+            }    
+
+            if(sig_inp->type == SignalInput::TypeSignals::kTS_int){
+                sig_inp->value = 0;
+            }else if(sig_inp->type == SignalInput::TypeSignals::kTS_double){
+                sig_inp->value = 0.0;
+            }else if(sig_inp->type == SignalInput::TypeSignals::kTS_string){
+                sig_inp->value = "";
+            }
+        }
+
+        registration.maps.update_value[sig_inp->kks].insert(sig_inp);
+
+        return sig_inp;
+    }
+
+    const SignalOutput* CalcServer::GetSignalOutput(const std::string& code, const std::string& table_name) const{
+        return FindByCode(maps_.code_to_signals_output, maps_.signals_output, code, table_name);
+    }
+    
+    const Coefficient* CalcServer::GetCoefficient(const std::string& code, const std::string& table_name) const{
+        return FindByCode(maps_.code_to_coefficients, maps_.coefficients, code, table_name);
+    }
+
+    const SignalInput* CalcServer::GetSignalInput(const std::string& code) const{
+        if(maps_.signals_input.count(code) == 0){
+            return nullptr;
+        }
+
+        return maps_.signals_input.at(code);
+    }
+
+    MapNameTableToValueCoefficientsPtr CalcServer::CreateCoefficients(const json& data_signal, Registration& registration){
+        MapNameTableToValueCoefficientsPtr coefficients;
+        std::string table_name;
+
+        if(auto iter_table_name = data_signal.find("table_name"); iter_table_name == data_signal.end()){
+            throw std::logic_error("Empty \"Coefficients\" object was found");
+        }else{
+            table_name = *iter_table_name;
+        }
+
+        auto iter_code_signals = data_signal.find("code_signals");
+        if(data_signal.find("code_signals") == data_signal.end()){
+            throw std::logic_error("Empty \"Coefficients\" object was found");
+        }
+
+        SignalMaps& maps = registration.maps;
+
+        for(const auto& code_and_row_data : *iter_code_signals){
+            auto code = code_and_row_data.find("code");
+
+            if( code == code_and_row_data.end()){
+                throw std::logic_error("Empty \"code\" field when parsing " + table_name);
+            }
+
+            std::set<std::string> rows;
+            if(auto row = code_and_row_data.find("row"); row != code_and_row_data.end()){
+                for(const auto& row_data : *row){
+                    rows.insert(row_data.get<std::string>());
+                }
+            }
+
+            Coefficient*& coef_for_insert = maps.coefficients[table_name][*code];
+            Coefficient* previous = (registration.previous == nullptr) ? nullptr : FindObject(registration.previous->coefficients, table_name, *code);
+
+            if(coef_for_insert == nullptr && previous != nullptr){
+                //Коэффициент текущего набора блоков остаётся со своими значениями, если ему не нужны новые строки
+                const auto& previous_rows = registration.previous->coefficient_rows.at(previous);
+                if(std::includes(previous_rows.begin(), previous_rows.end(), rows.begin(), rows.end())){
+                    coef_for_insert = previous;
+                    maps.coefficient_rows[previous] = previous_rows;
+                    RegisterCode(maps.code_to_coefficients, previous, table_name);
+                }
+            }
+
+            if(coef_for_insert == nullptr){
+                coef_for_insert = &store_coefficients_.Get(store_coefficients_.Add());
+            }
+
+            if(coef_for_insert->code == ""){
+                coef_for_insert->code = *code;
+                RegisterCode(maps.code_to_coefficients, coef_for_insert, table_name);
+            }
+
+            auto& known_rows = maps.coefficient_rows[coef_for_insert];
+
+            for(const auto& row : rows){
+                if(known_rows.insert(row).second){
+                    //Значения коэффициента текущего набора меняет шаг, в фоне строку добавить нельзя
+                    if(coef_for_insert == previous){
+                        throw std::logic_error("The row \"" + row + "\" was added to the coefficient \"" + coef_for_insert->code + "\" of the table " + table_name + " used by unchanged blocks");
+                    }
+                    coef_for_insert->data_row[row];
+                }
+            }
+
+            coefficients[table_name][*code] = coef_for_insert;
+        }
+
+        return coefficients;
+    }
+
+    SignalOutput* CalcServer::CreateSignalOutput(const json& data_signal, Registration& registration){
+        std::string code_str;
+        std::string table_name_str;
+        std::string table_col_str;
 
         if(auto code = data_signal.find("code"); code == data_signal.end()){
             throw std::logic_error("The \"Code\" field was not found in the output signal");
@@ -300,33 +1148,62 @@ namespace calc_server{
             table_name_str = *table_name;
         }
 
-        SignalOutput* sig_out = &signals_output_[table_name_str][code_str];
+        //Тип необязателен, без него в OutputSchema::kTyped столбец строковый
+        std::optional<SignalInput::TypeSignals> type_sig;
+        if(auto type = data_signal.find("type"); type != data_signal.end() && (*type != "")){
+            type_sig = static_cast<SignalInput::TypeSignals>((*type).dump()[1]);
+        }
+
+        SignalOutput*& sig_out = registration.maps.signals_output[table_name_str][code_str];
+
+        if(sig_out == nullptr && registration.previous != nullptr){
+            //Выходной сигнал текущего набора блоков остаётся, если столбец и тип в модели не изменились
+            if(SignalOutput* previous = FindObject(registration.previous->signals_output, table_name_str, code_str); previous != nullptr && previous->col_name == table_col_str){
+                auto previous_type = registration.previous->type_signals_output.find(previous);
+                bool has_previous_type = previous_type != registration.previous->type_signals_output.end();
+
+                if(has_previous_type == type_sig.has_value() && (!has_previous_type || previous_type->second == *type_sig)){
+                    sig_out = previous;
+                    RegisterCode(registration.maps.code_to_signals_output, sig_out, sig_out->table_name);
+                }
+            }
+        }
+
+        if(sig_out == nullptr){
+            sig_out = &store_signals_output_.Get(store_signals_output_.Add());
+        }
 
         if(sig_out->code == ""){
             sig_out->code = std::move(code_str);
             sig_out->col_name = std::move(table_col_str);
             sig_out->table_name = std::move(table_name_str);
+
+            RegisterCode(registration.maps.code_to_signals_output, sig_out, sig_out->table_name);
+        }
+
+        if(type_sig.has_value()){
+            registration.maps.type_signals_output[sig_out] = *type_sig;
         }
 
         return sig_out;
     }
 
-    MapNameInputSignalToDataPtr CalcServer::LoadSignalInput(const json& input_data){
+    MapNameInputSignalToDataPtr CalcServer::LoadSignalInput(const json& input_data, Registration& registration){
         MapNameInputSignalToDataPtr signals_input;
 
         for(const auto& input : input_data){
-            auto* sig_input = CreateSignalInput(input);
+            auto* sig_input = CreateSignalInput(input, registration);
             signals_input.insert({sig_input->code, sig_input});
         }
         
         return signals_input;
     }
 
-    MapNameTableToValueOutputSignalsPtr CalcServer::LoadSignalOutput(const json& output_data){
+    MapNameTableToValueOutputSignalsPtr CalcServer::LoadSignalOutput(const json& output_data, Registration& registration){
         MapNameTableToValueOutputSignalsPtr signals_output;
 
         for(const auto& output : output_data){
-            auto* output_signal = CreateSignalOutput(output);
+            auto* output_signal = CreateSignalOutput(output, registration);
 
             std::string table_name = output_signal->table_name;
             std::string code = output_signal->code;
@@ -337,517 +1214,1782 @@ namespace calc_server{
         return signals_output;
     }
 
-    MapNameTableToValueCoefficientsPtr CalcServer::LoadSignalCoefficient(const json& coef_data){
+    MapNameTableToValueCoefficientsPtr CalcServer::LoadSignalCoefficient(const json& coef_data, Registration& registration){
         MapNameTableToValueCoefficientsPtr coefficients;
 
         for(const auto& coef : coef_data){
-            coefficients.merge(CreateCoefficients(coef));               
+            coefficients.merge(CreateCoefficients(coef, registration));               
         }
         
         return coefficients;
     }
 
     bool CalcServer::CalcOneStep(double current_time, double step_calc){
+        return CalcStepAt(std::chrono::system_clock::now(), current_time, step_calc);
+    }
+
+    bool CalcServer::CalcStepAt(std::chrono::system_clock::time_point start_step, double current_time, double step_calc){
+        ApplyPendingReload();
+
+        step_start_time_ = start_step;
 
-        if(!UpdateValueInputSignals()){
-            return false; 
+        ScopedTimer timer_step(histogram_step_);
+
+        {
+            ScopedTimer timer_ingest(histogram_ingest_);
+
+            if(!UpdateValueInputSignals()){
+                return false; 
+            }
         }
 
+        return ComputeStep(current_time, step_calc);
+    }
+
+    bool CalcServer::ComputeStep(double current_time, double step_calc){
+
+        ApplyPendingCoefficients();
+
         try{
-            for(const auto& block: created_blocks_){
-                block->Process(current_time, step_calc);
+            {
+                ScopedTimer timer_process(histogram_process_);
+                ProcessBlocks(current_time, step_calc);
             }
 
             if(not_real_time_){
-                ++timestemp_;
+                timestemp_ += std::chrono::microseconds(std::llround(step_calc * 1e6));
             }else{
-                timestemp_ = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+                //Время начала шага (срок по расписанию), а не окончания расчёта блоков
+                timestemp_ = std::chrono::duration_cast<std::chrono::microseconds>(step_start_time_.time_since_epoch());
             }
 
             return WriteOutputSignalsToDatabase();
             
         }catch(const std::exception& e){
-            calc_server::logger.log(e.what(), Logger::LogLevel::kError);
+            calc_server::logger.LogLazy(Logger::LogLevel::kError, [&e](){
+                return std::string(e.what());
+            });
             std::cerr << e.what() << '\n';
 
-            return false;
+            return false;
+        }
+    }
+
+    CalcServer::ReplayResult CalcServer::RunReplay(const fs_path& path, double start_time, double step_calc, size_t max_steps){
+        ReplayResult result;
+        ReplayReader reader;
+
+        if(!reader.Open(path)){
+            logger.log("It is not possible to open the replay file: " + path.string(), Logger::LogLevel::kCritical);
+            return result;
+        }
+
+        //Время записи задаётся шагами, а не часами. При любом выходе прежний режим восстанавливается,
+        //иначе последующие CalcOneStep и StartRealTime продолжили бы считать время шагами
+        struct RestoreTimeMode{
+            bool& not_real_time;
+            bool saved;
+
+            ~RestoreTimeMode(){
+                not_real_time = saved;
+            }
+        } restore_time_mode{not_real_time_, not_real_time_};
+
+        not_real_time_ = true;
+
+        std::string_view line;
+        double current_time = start_time;
+
+        while((max_steps == 0 || result.steps < max_steps) && reader.NextLine(line)){
+            ApplyPendingReload();
+
+            ScopedTimer timer_step(histogram_step_);
+
+            {
+                ScopedTimer timer_ingest(histogram_ingest_);
+
+                kks_slot_table_.BeginUpdate();
+
+                if(!kks_slot_table_.ParseJSON(line)){
+                    kks_slot_table_.DiscardUpdate();
+                    logger.log("Invalid JSON in the replay file " + path.string() + " line: " + std::to_string(reader.GetLineNumber()), Logger::LogLevel::kError);
+                    return result;
+                }
+
+                //Строка может быть приращением, поэтому отсутствующие KKS не проверяются
+                kks_slot_table_.CommitUpdate();
+            }
+
+            if(!ComputeStep(current_time, step_calc)){
+                logger.log("Replay stopped at line: " + std::to_string(reader.GetLineNumber()), Logger::LogLevel::kError);
+                return result;
+            }
+
+            ++result.steps;
+            current_time += step_calc;
+        }
+
+        result.completed = FlushOutputSignals();
+
+        return result;
+    }
+
+    bool CalcServer::StartRealTime(const StepScheduler::Settings& settings, double start_time){
+        StopRealTime();
+
+        double period = std::chrono::duration<double>(settings.period).count();
+
+        if(settings.period < GetTimestempUnit()){
+            logger.log("The step period is shorter than the timestemp resolution, output rows will share timestemps", Logger::LogLevel::kWarning);
+        }
+
+        bool started = step_scheduler_.Start(settings, [this, start_time, period, settings](const StepScheduler::Tick& tick){
+            if(tick.index == 0 && step_scheduler_.HasThreadSettingsWarning()){
+                logger.log("It is not possible to apply CPU affinity or SCHED_FIFO to the step thread, it runs with default scheduling", Logger::LogLevel::kWarning);
+            }
+
+            if(histogram_start_jitter_ != nullptr){
+                histogram_start_jitter_->Record(tick.started - tick.scheduled);
+            }
+
+            bool success = CalcStepAt(tick.scheduled_system, start_time + period * static_cast<double>(tick.index), period);
+
+            if(StepScheduler::Clock::now() - tick.started > settings.period){
+                logger.LogLazy(Logger::LogLevel::kWarning, [&tick](){
+                    return "Step " + std::to_string(tick.index) + " took longer than the step period";
+                });
+            }
+
+            return success;
+        });
+
+        if(!started){
+            logger.log("It is not possible to start the step scheduler, the period must be positive", Logger::LogLevel::kError);
+        }
+
+        return started;
+    }
+
+    void CalcServer::StopRealTime(){
+        step_scheduler_.Stop();
+    }
+
+    CalcServer::StepsResult CalcServer::CalcSteps(double start_time, double step_calc, size_t count, const InputProvider& input_provider, const StopPredicate& stop_predicate){
+        //Внутри вызова набор блоков не меняется, чтобы слоты StepInput оставались действительными
+        ApplyPendingReload();
+
+        StepsResult result;
+        result.steps.reserve(count);
+
+        {
+            std::lock_guard lock(mutex_output_writer_);
+            output_batcher_.SetHold(true);
+        }
+
+        StepInput step_input(kks_slot_table_);
+        double current_time = start_time;
+
+        for(size_t index_step = 0; index_step < count; ++index_step){
+            step_start_time_ = std::chrono::system_clock::now();
+            ScopedTimer timer_step(histogram_step_);
+
+            bool input_ready;
+            {
+                ScopedTimer timer_ingest(histogram_ingest_);
+
+                if(input_provider){
+                    kks_slot_table_.BeginUpdate();
+                    input_ready = input_provider(index_step, current_time, step_input);
+
+                    if(input_ready){
+                        kks_slot_table_.CommitUpdate();
+                    }else{
+                        kks_slot_table_.DiscardUpdate();
+                    }
+                }else{
+                    input_ready = UpdateValueInputSignals();
+                }
+            }
+
+            if(!input_ready){
+                result.steps.push_back(StepStatus::kInputError);
+                break;
+            }
+
+            if(!ComputeStep(current_time, step_calc)){
+                result.steps.push_back(StepStatus::kCalcError);
+                break;
+            }
+
+            result.steps.push_back(StepStatus::kOk);
+
+            if(stop_predicate && stop_predicate(index_step, current_time)){
+                result.stopped = true;
+                break;
+            }
+
+            current_time += step_calc;
+        }
+
+        {
+            std::lock_guard lock(mutex_output_writer_);
+            output_batcher_.SetHold(false);
+        }
+
+        result.flushed = FlushOutputSignals();
+
+        return result;
+    }
+
+    void CalcServer::ProcessBlocks(double current_time, double step_calc){
+        bool process_all = !incremental_mode_ || need_process_all_ || block_graph_.GetCountBlocks() != created_blocks_.size();
+
+        if(!process_all){
+            MarkActiveBlocks();
+        }
+
+        kks_slot_table_.ClearChangedSignals();
+        changed_coefficients_.clear();
+
+        //Если шаг прервётся исключением, на следующем шаге выполняются все блоки
+        need_process_all_ = true;
+
+        if(metrics_enabled_ && histogram_blocks_.size() != created_blocks_.size()){
+            RegisterBlockMetrics();
+        }
+
+        if(block_pool_ == nullptr || block_graph_.GetCountBlocks() != created_blocks_.size()){
+            for(size_t block = 0; block < created_blocks_.size(); ++block){
+                if(process_all || active_blocks_[block]){
+                    ProcessBlock(block, current_time, step_calc);
+                }
+            }
+        }else{
+            block_graph_.Run(*block_pool_, [this, current_time, step_calc, process_all](int block){
+                if(process_all || active_blocks_[block]){
+                    ProcessBlock(block, current_time, step_calc);
+                }
+            });
+        }
+
+        need_process_all_ = false;
+    }
+
+    void CalcServer::ProcessBlock(size_t block, double current_time, double step_calc){
+        ScopedTimer timer_block((metrics_enabled_) ? histogram_blocks_[block] : nullptr);
+        created_blocks_[block]->Process(current_time, step_calc);
+    }
+
+    void CalcServer::SetMetrics(bool enabled, std::filesystem::path path, std::chrono::milliseconds interval){
+        metrics_.StopExport();
+        metrics_enabled_ = enabled;
+
+        if(!enabled){
+            histogram_step_ = histogram_ingest_ = histogram_process_ = nullptr;
+            histogram_serialization_ = histogram_enqueue_ = histogram_coefficient_reload_ = nullptr;
+            histogram_start_jitter_ = nullptr;
+            return;
+        }
+
+        histogram_step_ = &metrics_.GetHistogram("calc_server_step_seconds", "Duration of CalcOneStep");
+        histogram_ingest_ = &metrics_.GetHistogram("calc_server_ingest_seconds", "Reading and applying input signals");
+        histogram_process_ = &metrics_.GetHistogram("calc_server_process_seconds", "Processing of all calculation blocks in a step");
+        histogram_serialization_ = &metrics_.GetHistogram("calc_server_output_serialization_seconds", "Formatting output signals of a step");
+        histogram_enqueue_ = &metrics_.GetHistogram("calc_server_output_enqueue_seconds", "Queueing output INSERT requests to the database");
+        histogram_coefficient_reload_ = &metrics_.GetHistogram("calc_server_coefficient_reload_seconds", "Receiving and parsing coefficient tables");
+        histogram_start_jitter_ = &metrics_.GetHistogram("calc_server_step_start_jitter_seconds", "Delay of the step start after its scheduled time");
+
+        RegisterBlockMetrics();
+
+        if(!path.empty()){
+            metrics_.StartExport(std::move(path), interval);
+        }
+    }
+
+    void CalcServer::RegisterBlockMetrics(){
+        //Гистограмма блока с тем же типом и именем остаётся со своими значениями, удаляются только блоки,
+        //которых нет в текущем наборе
+        histogram_blocks_.clear();
+
+        for(size_t block = 0; block < created_blocks_.size(); ++block){
+            const std::string& type = (block < blocks_wiring_.size()) ? blocks_wiring_[block].type : "";
+            const std::string& name = (block < blocks_wiring_.size()) ? blocks_wiring_[block].name : "";
+
+            //Метка - имя блока, а не его номер: номер меняется при перезагрузке и перезапуске
+            histogram_blocks_.push_back(&metrics_.GetHistogram(
+                "calc_server_block_process_seconds",
+                "Duration of Process of one calculation block",
+                {{"type", type}, {"block", name}}
+            ));
+        }
+
+        metrics_.Remove("calc_server_block_process_seconds", std::unordered_set<const LatencyHistogram*>(histogram_blocks_.begin(), histogram_blocks_.end()));
+    }
+
+    void CalcServer::MarkActiveBlocks(){
+        active_blocks_.assign(created_blocks_.size(), 0);
+
+        std::vector<int> queue_blocks;
+
+        auto activate = [this, &queue_blocks](int block){
+            if(!active_blocks_[block]){
+                active_blocks_[block] = 1;
+                queue_blocks.push_back(block);
+            }
+        };
+
+        auto activate_readers = [this, &activate](const void* object){
+            if(auto iter_blocks = object_to_blocks_.find(object); iter_blocks != object_to_blocks_.end()){
+                for(int block : iter_blocks->second){
+                    activate(block);
+                }
+            }
+        };
+
+        for(const SignalInput* signal : kks_slot_table_.GetChangedSignals()){
+            activate_readers(signal);
+        }
+
+        for(const Coefficient* coefficient : changed_coefficients_){
+            activate_readers(coefficient);
+        }
+
+        for(size_t block = 0; block < blocks_wiring_.size(); ++block){
+            if(blocks_wiring_[block].always_process || always_process_types_.contains(blocks_wiring_[block].type)){
+                activate(static_cast<int>(block));
+            }
+        }
+
+        //Блоки, пишущие в те же выходные сигналы после активного блока, должны выполниться тоже,
+        //иначе в сигнале останется значение активного блока, а не последнего по порядку
+        while(!queue_blocks.empty()){
+            int block = queue_blocks.back();
+            queue_blocks.pop_back();
+
+            for(int successor : block_graph_.GetSuccessors(block)){
+                activate(successor);
+            }
+        }
+    }
+
+    void CalcServer::SetCountThreads(size_t count_threads){
+        count_threads_ = std::max<size_t>(count_threads, 1);
+
+        if(count_threads_ == 1){
+            block_pool_.reset();
+        }else if(block_pool_ == nullptr || block_pool_->GetCountThreads() != count_threads_){
+            block_pool_ = std::make_unique<WorkStealingPool>(count_threads_);
+        }
+
+        BuildBlockGraph();
+    }
+
+    void CalcServer::SetIncrementalMode(bool incremental){
+        incremental_mode_ = incremental;
+        BuildBlockGraph();
+    }
+
+    void CalcServer::SetAlwaysProcessType(const std::string& type_block){
+        always_process_types_.insert(type_block);
+    }
+
+    void CalcServer::BuildBlockGraph(){
+        need_process_all_ = true;
+        object_to_blocks_.clear();
+
+        if(block_pool_ == nullptr && !incremental_mode_){
+            block_graph_.Clear();
+            return;
+        }
+
+        std::vector<std::vector<const void*>> written_objects(blocks_wiring_.size());
+
+        for(size_t block = 0; block < blocks_wiring_.size(); ++block){
+            const BlockWiring& wiring = blocks_wiring_[block];
+
+            written_objects[block].assign(wiring.outputs.begin(), wiring.outputs.end());
+
+            if(incremental_mode_){
+                for(const SignalInput* signal : wiring.inputs){
+                    object_to_blocks_[signal].push_back(static_cast<int>(block));
+                }
+                for(const Coefficient* coefficient : wiring.coefficients){
+                    object_to_blocks_[coefficient].push_back(static_cast<int>(block));
+                }
+            }
+        }
+
+        block_graph_.Build(written_objects);
+    }
+
+    json CalcServer::GenerateJSONForDebug(double time_calc, double step_calc){
+
+        json json_with_input_sig;
+
+        for(const auto& function_dll : created_blocks_){
+            function_dll->GenerateDebugData(json_with_input_sig, time_calc, step_calc);
+        }
+
+        return json_with_input_sig;
+    }
+
+    void CalcServer::BuildInputSlots(){
+        kks_slot_table_.Build(maps_.update_value);
+        input_file_watcher_.Reset();
+        shared_memory_input_.ResetMapping();
+
+        slots_check_missing_.clear();
+        for(int slot = 0; slot < static_cast<int>(kks_slot_table_.GetCountSlots()); ++slot){
+            const std::string& kks = kks_slot_table_.GetKKS(slot);
+            if(kks.size() < 8 && kks[0] == 'K' && kks[1] == 'K' && kks[2] == 'S' && kks[3] == '_' && std::isdigit(kks[4]) && std::isdigit(kks[5]) && std::isdigit(kks[6])){
+                slots_check_missing_.push_back(slot);
+            }
+        }
+
+        slots_reported_missing_.assign(slots_check_missing_.size(), 0);
+    }
+
+    bool CalcServer::UpdateValueInputSignals(const std::string& name_file_inp){
+        if(input_mode_ == InputMode::kSharedMemory){
+            return UpdateValueInputSignalsFromSharedMemory();
+        }
+
+        const std::string& name_file = (name_file_inp == "") ?  name_inp_file_json_ : name_file_inp;
+
+        if(input_mode_ == InputMode::kWatchChanges){
+            input_file_watcher_.SetPath(name_file);
+
+            auto state_file = input_file_watcher_.CheckChanges();
+
+            if(state_file == InputFileWatcher::StateFile::kUnchanged){
+                return true;
+            }
+
+            if(state_file == InputFileWatcher::StateFile::kChanged){
+                bool result = ApplyValueInputSignals(input_file_watcher_.GetContent(), name_file);
+
+                if(!result){
+                    //Файл мог быть прочитан во время записи, на следующем шаге он будет прочитан заново
+                    input_file_watcher_.Reset();
+                }
+
+                return result;
+            }
+        }else{
+            if(ReadFileContent(name_file, input_file_content_)){
+                return ApplyValueInputSignals(input_file_content_, name_file);
+            }
+        }
+
+        calc_server::logger.LogLazy(Logger::LogLevel::kCritical, [&name_file](){
+            return "It is not possible to open a file with the name: " + name_file;
+        });
+
+        std::cerr << "It is not possible to open a file with the name: " << name_file << std::endl;
+
+        return false;
+    }
+
+    bool CalcServer::ApplyValueInputSignals(std::string_view content, const std::string& name_file){
+        kks_slot_table_.BeginUpdate();
+
+        if(!kks_slot_table_.ParseJSON(content)){
+            kks_slot_table_.DiscardUpdate();
+            calc_server::logger.LogLazy(Logger::LogLevel::kError, [&name_file](){
+                return "Invalid JSON in the file with the name: " + name_file;
+            });
+            return false;
+        }
+
+        kks_slot_table_.CommitUpdate();
+        CheckMissingInputSignals();
+
+        return true;
+    }
+
+    bool CalcServer::UpdateValueInputSignalsFromSharedMemory(){
+        auto state_read = shared_memory_input_.ReadSnapshot(kks_slot_table_);
+
+        if(state_read == SharedMemoryInput::StateRead::kUnchanged){
+            return true;
+        }
+
+        if(state_read == SharedMemoryInput::StateRead::kError){
+            calc_server::logger.LogLazy(Logger::LogLevel::kCritical, [this](){
+                return "It is not possible to read the shared memory segment: " + shared_memory_input_.GetName();
+            });
+            return false;
+        }
+
+        kks_slot_table_.CommitUpdate();
+        CheckMissingInputSignals();
+
+        return true;
+    }
+
+    void CalcServer::CheckMissingInputSignals(){
+        //Каждый KKS сообщается, когда пропадает, а не на каждом шаге: общий лимит LogLazy называл бы
+        //одни и те же первые KKS, а остальные попадали бы только в счётчик повторов
+        for(size_t index = 0; index < slots_check_missing_.size(); ++index){
+            int slot = slots_check_missing_[index];
+
+            if(kks_slot_table_.IsUpdated(slot)){
+                slots_reported_missing_[index] = 0;
+                continue;
+            }
+
+            if(!slots_reported_missing_[index]){
+                slots_reported_missing_[index] = 1;
+                calc_server::logger.log("It is impossible to find a signal from KKS: " + kks_slot_table_.GetKKS(slot), Logger::LogLevel::kError);
+            }
+        }
+    }
+
+    void CalcServer::SetOutputFile(std::string name){
+        name_inp_file_json_ = std::move(name);
+    }
+
+    void CalcServer::SetInputMode(InputMode mode){
+        input_mode_ = mode;
+        input_file_watcher_.Reset();
+        shared_memory_input_.ResetMapping();
+    }
+
+    void CalcServer::SetInputSharedMemory(std::string name_segment){
+        shared_memory_input_.SetName(std::move(name_segment));
+        SetInputMode(InputMode::kSharedMemory);
+    }
+
+    [[nodiscard]] bool CalcServer::ConnectDatabase(const std::string& name_connect){
+
+            using namespace std::literals;
+
+            if(!db_client_->IsConfigRequired()){
+                ConnectionInfo data_connection;
+                data_connection.id_connection = name_connect;
+                return db_client_->CreateConnectionDatabase(data_connection);
+            }
+
+            std::ifstream json_model_file("ConfigDB.json");
+
+            if(!json_model_file.is_open()){
+                logger.log("The JSON file with the settings was not found: "s + "ConfigDB.json"s, Logger::LogLevel::kError);
+                return false;
+            }
+            
+            const json config_db = json::parse(json_model_file);
+            auto name_config = config_db.find(name_connect);
+
+            if(name_config == config_db.end()){
+                logger.log("No data was found for the configuration launch of the database. Name configuration: " + name_connect, Logger::LogLevel::kError);
+                return false;
+            }
+
+            auto data_connection = ConnectionInfo::ConnectionInfo::ConvertFromJSON(
+                *name_config
+            );
+
+            data_connection.id_connection = name_connect;
+
+            if(data_connection.dbname == ""){
+                logger.log(R"(The "DataBaseName" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
+                return false;
+            }
+
+            if(data_connection.hostname == ""){
+                logger.log(R"(The "HostName" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
+                return false;
+            }
+
+            if(data_connection.user == ""){
+                logger.log(R"(The "UserName" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
+                return false;
+            }
+
+            if(data_connection.password == ""){
+                logger.log(R"(The "Password" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
+                return false;
+            }
+
+            if(!db_client_->CreateConnectionDatabase(data_connection)){
+                logger.log( R"(Не удалось создать подключение к базе данных с настройками, указанными в "ConfigDB.json" для конфигурации: )" + name_connect, Logger::LogLevel::kCritical);
+                return false;
+            }
+
+            return true;
+    }
+
+    bool CalcServer::PreparingServerCalculation(){
+
+        if(created_blocks_.empty()){
+            logger.log("There are no calculation blocks created. The necessary configuration data may not have loaded. Check the errors above.", Logger::LogLevel::kCritical);
+            return false;
+        }
+
+        BuildBlockGraph();
+
+        //Если модели и окружение не изменились, списки таблиц берутся из снимка без запросов к information_schema
+        bool tables_from_snapshot = RestoreTablesFromSnapshot();
+
+        if(!tables_from_snapshot){
+            UpdateListExistTable(name_db_coefficient_);
+        }
+
+        for(const auto& [name_table, content] : maps_.coefficients){
+            if(!CheckTableExist(name_table, name_db_coefficient_)){
+                logger.log("Coefficients. The table does not exist in the database specified for connection: " + name_table, Logger::LogLevel::kCritical);
+                return false;
+            }
+        }
+
+        bool prepared = (tables_from_snapshot || PreparingOutputTables(maps_.signals_output, maps_, name_db_to_exist_tables_[name_db_out_])) && PreparingRecordRequestOut() && PreparingRecordRequestCoef();
+
+        if(prepared && !path_model_snapshot_.empty()){
+            if(!tables_from_snapshot){
+                SaveModelSnapshot();
+            }
+
+            //Копии моделей больше не нужны
+            model_snapshot_ = json();
+            model_snapshot_update_ = json();
+            model_snapshot_complete_ = false;
+        }
+
+        return prepared;
+    }
+
+    void CalcServer::SetModelSnapshot(fs_path path){
+        path_model_snapshot_ = std::move(path);
+        model_snapshot_ = json();
+        model_snapshot_update_ = json();
+        model_snapshot_complete_ = true;
+        count_model_loads_ = 0;
+        count_model_loads_from_snapshot_ = 0;
+    }
+
+    bool CalcServer::TakeModelsFromSnapshot(uint64_t key_models, std::vector<json>& load_jsons){
+        if(count_model_loads_ == 0){
+            std::string error;
+            if(!ReadSnapshot(path_model_snapshot_, model_snapshot_, error)){
+                logger.log("The model snapshot is not used (" + error + "), it will be rebuilt: " + path_model_snapshot_.string(), Logger::LogLevel::kInfo);
+                model_snapshot_ = json();
+                return false;
+            }
+        }
+
+        if(!model_snapshot_.is_object()){
+            return false;
+        }
+
+        auto models = model_snapshot_.find("models");
+        if(models == model_snapshot_.end() || !models->is_array() || count_model_loads_ >= models->size()){
+            return false;
+        }
+
+        json& entry = (*models)[count_model_loads_];
+        auto files = entry.find("files");
+
+        if(entry.value("key", uint64_t{0}) != key_models || files == entry.end() || !files->is_array()){
+            logger.log("The model files have changed, the model snapshot will be rebuilt", Logger::LogLevel::kInfo);
+            return false;
+        }
+
+        load_jsons.clear();
+        load_jsons.reserve(files->size());
+        for(auto& file : *files){
+            load_jsons.push_back(std::move(file));
+        }
+
+        ++count_model_loads_from_snapshot_;
+        return true;
+    }
+
+    uint64_t CalcServer::ComputeEnvironmentKey() const{
+        KeyHasher key;
+
+        key.Add(static_cast<uint64_t>(output_schema_));
+
+        std::vector<std::string> builtin_types;
+        for(const auto& [type, create_block] : builtin_block_types_){
+            builtin_types.push_back(type);
+        }
+        std::sort(builtin_types.begin(), builtin_types.end());
+
+        for(const auto& type : builtin_types){
+            key.Add(type);
+        }
+
+        //Версия плагина - размер и время изменения файла
+        for(const auto& directory : dll_directories_){
+            std::vector<fs_path> files_dll;
+            std::error_code code_error;
+
+            for(const auto& entry : std::filesystem::directory_iterator(directory, code_error)){
+                if(entry.path().extension() == ".dll"){
+                    files_dll.push_back(entry.path());
+                }
+            }
+            std::sort(files_dll.begin(), files_dll.end());
+
+            key.Add(directory.string());
+            for(const auto& file : files_dll){
+                (void)key.AddFileStamp(file);
+            }
+        }
+
+        if(db_client_->IsConfigRequired()){
+            (void)key.AddFileContent("ConfigDB.json");
+        }
+
+        return key.Get();
+    }
+
+    bool CalcServer::RestoreTablesFromSnapshot(){
+        if(!model_snapshot_.is_object() || count_model_loads_ == 0 || count_model_loads_from_snapshot_ != count_model_loads_){
+            return false;
+        }
+
+        auto models = model_snapshot_.find("models");
+        if(models == model_snapshot_.end() || models->size() != count_model_loads_){
+            return false;
+        }
+
+        if(model_snapshot_.value("environment", uint64_t{0}) != ComputeEnvironmentKey()){
+            logger.log("Plugins or settings have changed, the model snapshot will be rebuilt", Logger::LogLevel::kInfo);
+            return false;
+        }
+
+        auto tables = model_snapshot_.find("exist_tables");
+        if(tables == model_snapshot_.end() || !tables->is_object()){
+            return false;
+        }
+
+        try{
+            for(const auto& name_connection : {name_db_out_, name_db_coefficient_}){
+                name_db_to_exist_tables_[name_connection] = tables->at(name_connection).get<std::set<std::string>>();
+            }
+        }catch(const std::exception& e){
+            logger.log("The model snapshot is damaged: " + std::string(e.what()), Logger::LogLevel::kWarning);
+            return false;
+        }
+
+        if(!CheckSnapshotTables()){
+            return false;
+        }
+
+        logger.log("Models and table layout were restored from the snapshot: " + path_model_snapshot_.string(), Logger::LogLevel::kInfo);
+        return true;
+    }
+
+    bool CalcServer::CheckSnapshotTables(){
+        //Снимок не знает об изменениях в базе: таблицы могли удалить, а базу восстановить или пересоздать.
+        //Один запрос к information_schema.columns на подключение, при расхождении - полная подготовка таблиц
+        std::set<std::string> output_tables;
+        std::set<std::string> coefficient_tables;
+        std::unordered_map<std::string, std::set<std::string>> output_columns;
+        std::unordered_map<std::string, std::set<std::string>> coefficient_columns;
+
+        for(const auto& [name_table, content] : maps_.signals_output){
+            output_tables.insert(GetLowwerString(name_table));
+        }
+
+        for(const auto& [name_table, content] : maps_.coefficients){
+            coefficient_tables.insert(GetLowwerString(name_table));
+        }
+
+        if(!SelectTableColumns(name_db_out_, output_tables, output_columns) || !SelectTableColumns(name_db_coefficient_, coefficient_tables, coefficient_columns)){
+            logger.log("It is not possible to check the tables of the model snapshot, the tables will be prepared again", Logger::LogLevel::kWarning);
+            return false;
+        }
+
+        for(const auto& name_table : coefficient_tables){
+            if(!coefficient_columns.contains(name_table)){
+                logger.log("The coefficient table from the model snapshot is missing in the database: " + name_table + ". The tables will be prepared again", Logger::LogLevel::kWarning);
+                return false;
+            }
+        }
+
+        for(const auto& [name_table, content] : maps_.signals_output){
+            auto columns = output_columns.find(GetLowwerString(name_table));
+
+            if(columns == output_columns.end()){
+                logger.log("The output table from the model snapshot is missing in the database: " + name_table + ". The tables will be prepared again", Logger::LogLevel::kWarning);
+                return false;
+            }
+
+            if(!columns->second.contains("timestemp")){
+                logger.log("There is no column \"timestemp\" in the output table " + name_table + " from the model snapshot. The tables will be prepared again", Logger::LogLevel::kWarning);
+                return false;
+            }
+
+            for(const auto& [name_signal, value_signal] : content){
+                if(name_signal == "timestemp"){
+                    continue;
+                }
+
+                for(const auto& [name_column, type_column] : GetOutputColumns(*value_signal, maps_)){
+                    if(!columns->second.contains(GetLowwerString(name_column))){
+                        logger.log("There is no column \"" + name_column + "\" in the output table " + name_table + " from the model snapshot. The tables will be prepared again", Logger::LogLevel::kWarning);
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void CalcServer::SaveModelSnapshot(){
+        if(!model_snapshot_complete_){
+            logger.log("The model snapshot was not saved because of errors in the model files", Logger::LogLevel::kWarning);
+            return;
+        }
+
+        model_snapshot_update_["environment"] = ComputeEnvironmentKey();
+
+        json& tables = model_snapshot_update_["exist_tables"];
+        for(const auto& name_connection : {name_db_out_, name_db_coefficient_}){
+            tables[name_connection] = name_db_to_exist_tables_[name_connection];
+        }
+
+        if(!WriteSnapshot(path_model_snapshot_, model_snapshot_update_)){
+            logger.log("It is not possible to write the model snapshot: " + path_model_snapshot_.string(), Logger::LogLevel::kError);
+            return;
+        }
+
+        logger.log("The model snapshot was saved: " + path_model_snapshot_.string(), Logger::LogLevel::kInfo);
+    }
+
+
+    bool CalcServer::PreparingOutputTables(const MapNameTableToValueOutputSignals& tables, const SignalMaps& maps, std::set<std::string>& exist_tables){
+
+        UpdateListExistTable(name_db_out_, exist_tables);
+
+        //Существующие столбцы всех выходных таблиц одним запросом
+        std::unordered_map<std::string, std::set<std::string>> table_to_columns;
+        std::set<std::string> select_tables;
+
+        for(const auto& [name_table, content] : tables){
+            if(CheckTableExist(name_table, exist_tables)){
+                select_tables.insert(GetLowwerString(name_table));
+                table_to_columns[GetLowwerString(name_table)];
+            }
+        }
+
+        if(!SelectTableColumns(name_db_out_, select_tables, table_to_columns)){
+            return false;
+        }
+
+        //Все изменения схемы выполняются одним анонимным блоком, то есть в одной транзакции
+        std::string query_schema;
+        size_t count_changed_tables = 0;
+
+        for(const auto& [name_table, content] : tables){
+            auto columns = table_to_columns.find(GetLowwerString(name_table));
+
+            if(columns == table_to_columns.end()){
+                std::string query_create = "CREATE TABLE " + GetLowwerString(name_table) + " (" + "id bigserial, ";
+
+                if(name_table.back() != '9'){
+                    query_create += "timestemp " + GetTimestempType() + ", ";
+                }
+                
+                bool first = true;
+                for (const auto& [name_sig, data_out] : content){
+                    for(const auto& [name_column, type_column] : GetOutputColumns(*data_out, maps)){
+
+                        if(first){
+                            query_create += name_column + " " + type_column;
+                            first = false;
+                            continue;
+                        }
+
+                        query_create += ", " + name_column + " " + type_column;
+                    }
+                }
+                
+                (name_table.back() == '6') ? query_create += ", status BOOLEAN NOT NULL DEFAULT false": query_create;
+                query_create += ")";
+
+                query_schema += query_create + "; ";
+                ++count_changed_tables;
+
+                logger.log("A table with the name will be created: " + name_table, Logger::LogLevel::kInfo);
+                continue;
+            }
+
+            std::string quere_request_new_column;
+            bool first = true;
+
+            const auto& map_column = columns->second;
+
+            for(const auto& output_signal : content){
+                for(const auto& [name_column, type_column] : GetOutputColumns(*output_signal.second, maps)){
+                    if(map_column.find(GetLowwerString(name_column)) == map_column.end()){
+                        if(first){
+                            quere_request_new_column = " ADD COLUMN " + name_column + " " + type_column;
+                            first = false;
+                            continue;
+                        }
+                        quere_request_new_column += ", ADD COLUMN " + name_column + " " + type_column;
+                    }
+                }
+            }
+
+            std::string quere = "ALTER TABLE " + GetLowwerString(name_table);
+            (!map_column.contains(("id"))) ?
+                        (quere_request_new_column == "") ? quere_request_new_column += " ADD COLUMN id bigserial" : quere_request_new_column += ", ADD COLUMN id bigserial" :
+                        quere_request_new_column ;
+
+            (!map_column.contains(("timestemp"))) ?
+                        (quere_request_new_column == "") ? quere_request_new_column += " ADD COLUMN timestemp " + GetTimestempType() : quere_request_new_column += ", ADD COLUMN timestemp " + GetTimestempType() :
+                        quere_request_new_column ;
+
+            (name_table.back() == '6' && (!map_column.contains(("status")))) ?
+                        (quere_request_new_column != "") ?
+                            quere_request_new_column += ", ADD COLUMN status BOOLEAN NOT NULL DEFAULT false":
+                            quere_request_new_column += " ADD COLUMN status BOOLEAN NOT NULL DEFAULT false":
+                        quere_request_new_column;
+
+            if(quere_request_new_column != ""){
+                query_schema += quere + quere_request_new_column + "; ";
+                ++count_changed_tables;
+
+                logger.log("Request will be processed: " + quere_request_new_column + " in table: " + name_table, Logger::LogLevel::kInfo);
+            }
+        }
+
+        if(count_changed_tables != 0){
+            query_schema = "DO $calc_server$ BEGIN " + query_schema + "END $calc_server$";
+
+            auto request_schema = request_tracker_.Submit(name_db_out_, query_schema, {}, Command::kInsert, "All_tables");
+
+            if(!request_schema.IsValid()){
+                logger.log("Request processing error when preparing output tables", Logger::LogLevel::kCritical);
+                return false;
+            }
+
+            if(request_schema.Wait(kTimeoutRequest).id_request == -1){
+                logger.log("Timeout preparing output tables", Logger::LogLevel::kCritical);
+                return false;
+            }
+
+            //Проверка, что транзакция применилась
+            if(!UpdateListExistTable(name_db_out_, exist_tables)){
+                return false;
+            }
+
+            for(const auto& [name_table, content] : tables){
+                if(!CheckTableExist(name_table, exist_tables)){
+                    logger.log("The output table was not created, check the \"DatabaseLog.txt\" file: " + name_table, Logger::LogLevel::kCritical);
+                    return false;
+                }
+            }
+
+            logger.log("Output tables prepared, changed: " + std::to_string(count_changed_tables), Logger::LogLevel::kInfo);
+        }
+        
+        return true;
+    }
+
+    bool CalcServer::SelectTableColumns(const std::string& name_connection, const std::set<std::string>& tables, std::unordered_map<std::string, std::set<std::string>>& table_to_columns){
+        if(tables.empty()){
+            return true;
+        }
+
+        std::string tables_query = "{";
+        for(const auto& name_table : tables){
+            tables_query += ((tables_query.size() > 1) ? ",\"" : "\"") + name_table + "\"";
+        }
+        tables_query += "}";
+
+        std::string query_select = "SELECT table_name || '.' || column_name AS table_column, table_name, column_name FROM information_schema.columns "
+                                    "WHERE table_schema = 'public' AND table_name::text = ANY($1::text[])";
+
+        auto request_select = request_tracker_.Submit(name_connection, query_select, {tables_query}, Command::kSelect, "All_columns");
+
+        if(!request_select.IsValid()){
+            logger.log("Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kCritical);
+            return false;
+        }
+
+        auto exist_columns = request_select.Wait(kTimeoutRequest);
+
+        if(exist_columns.id_request == -1){
+            return false;
+        }
+
+        for(auto& [table_column, fields] : exist_columns.code_to_map_field_value){
+            auto table = fields.find("table_name");
+            auto column = fields.find("column_name");
+
+            if(table != fields.end() && column != fields.end()){
+                table_to_columns[GetLowwerString(table->second)].insert(GetLowwerString(column->second));
+            }
+        }
+
+        return true;
+    }
+
+    bool CalcServer::PreparingRecordRequestOut(){
+
+        output_tables_.clear();
+        last_written_output_.clear();
+
+        for(const auto& [table_name, data_table] : maps_.signals_output){
+            bool first = true;
+            std::string quere_request_column = "INSERT INTO " + GetLowwerString(table_name) + " (";;
+            size_t count_columns = 0;
+            std::vector<std::string> placeholders;
+
+            OutputTableLayout layout;
+            layout.name = table_name;
+
+            for(const auto& [name_signal, value_signal] : data_table){
+                if(name_signal != "timestemp"){
+                    layout.signals.push_back(value_signal);
+                }
+            }
+
+            //Столбцы в порядке расположения сигналов в хранилище, снимок шага читает память подряд
+            std::sort(layout.signals.begin(), layout.signals.end(), std::less<const SignalOutput*>());
+
+            for(const SignalOutput* value_signal : layout.signals){
+                auto columns = GetOutputColumns(*value_signal, maps_);
+                for(size_t i = 0; i < columns.size(); ++i){
+                    const auto& [name_column, type_column] = columns[i];
+
+                    //Для kDelta пустая строка в параметре - сигнал не изменился, в таблицу пишется NULL.
+                    //Записанное значение идёт с префиксом kMarkerSentCell, поэтому пустая строка сигнала не путается с пропуском.
+                    //Столбец проблемы остаётся как есть: о неизменности говорит NULL в столбце значения.
+                    if(output_recording_ == OutputRecording::kDelta && !(output_schema_ == OutputSchema::kTyped && i == 2)){
+                        placeholders.push_back("substr(NULLIF({}, ''), 2)::" + type_column);
+                    }else{
+                        placeholders.emplace_back();
+                    }
+
+                    if(first){
+                        quere_request_column += name_column;
+                        ++count_columns;
+                        first = false;
+                        continue;
+                    }
+
+                    quere_request_column += ", " + name_column;
+                    ++count_columns;
+                }
+            }
+
+            quere_request_column += ", " + std::string{"timestemp"};
+            ++count_columns;
+
+            quere_request_column += ")";
+
+            placeholders.push_back((output_schema_ == OutputSchema::kTyped) ? "to_timestamp({})" : "");
+
+            layout.index_batcher = output_batcher_.RegisterTable(table_name, std::move(quere_request_column), count_columns, std::move(placeholders));
+            name_table_to_request_insert_[table_name] = output_batcher_.GetInsertRequest(layout.index_batcher, 1);
+
+            last_written_output_.emplace_back(layout.signals.size());
+            output_tables_.push_back(std::move(layout));
+
+            #ifdef DEBUG
+                logger.log("Request insert: " + name_table_to_request_insert_[table_name] + " in table: " + table_name);
+            #endif
+        }           
+
+        return true;
+
+    }
+
+    bool CalcServer::WriteOutputSignalsToDatabase(){
+
+        if(output_pipeline_ != nullptr){
+            TakeOutputSnapshot(output_pipeline_->GetBufferToFill());
+            output_pipeline_->Push();
+
+            //Ошибка записи предыдущих снимков видна с опозданием: писатель работает в фоне
+            return !TakeNewOutputWriteErrors();
+        }
+
+        TakeOutputSnapshot(output_snapshot_);
+
+        std::lock_guard lock(mutex_output_writer_);
+        return WriteOutputSnapshot(output_snapshot_);
+    }
+
+    void CalcServer::TakeOutputSnapshot(OutputSnapshot& snapshot) const{
+        snapshot.timestemp = timestemp_;
+        snapshot.tables.resize(output_tables_.size());
+
+        for(size_t table = 0; table < output_tables_.size(); ++table){
+            const auto& signals = output_tables_[table].signals;
+            auto& values = snapshot.tables[table];
+
+            values.resize(signals.size());
+
+            for(size_t index_signal = 0; index_signal < signals.size(); ++index_signal){
+                const SignalOutput& signal = *signals[index_signal];
+                OutputValue& value = values[index_signal];
+
+                value.value = signal.value;
+                value.color = static_cast<int>(signal.highlight_value.current_color);
+                value.id_problem = signal.id_problem;
+            }
+        }
+    }
+
+    bool CalcServer::WriteOutputSnapshot(const OutputSnapshot& snapshot){
+
+        std::optional<ScopedTimer> timer_serialization(std::in_place, histogram_serialization_);
+
+        bool delta_recording = output_recording_ == OutputRecording::kDelta;
+        bool keyframe = !delta_recording || steps_since_keyframe_ == 0;
+        size_t count_columns_signal = (output_schema_ == OutputSchema::kTyped) ? 3 : 1;
+        //Столбцы сигнала с NULLIF в запросе kDelta: значение (и цвет для kTyped)
+        size_t count_marked_columns = (output_schema_ == OutputSchema::kTyped) ? 2 : 1;
+        std::vector<size_t> sent_signals;
+        
+        for(size_t table = 0; table < output_tables_.size() && table < snapshot.tables.size(); ++table){
+
+            const auto& data_table = snapshot.tables[table];
+            auto& last_written = last_written_output_[table];
+
+            bool no_empty_data = false;
+            bool changed_row = false;
+            sent_signals.clear();
+            std::vector<std::string> value_signals;
+            value_signals.reserve(count_columns_signal * data_table.size() + 1);
+
+            for(size_t index_signal = 0; index_signal < data_table.size(); ++index_signal){
+
+                const OutputValue& value_signal = data_table[index_signal];
+
+                if(delta_recording){
+                    bool changed = IsChangedOutput(last_written[index_signal], value_signal);
+                    changed_row |= changed;
+
+                    //Неизменившиеся сигналы записываются как NULL
+                    if(!keyframe && !changed){
+                        value_signals.resize(value_signals.size() + count_columns_signal);
+                        continue;
+                    }
+
+                    sent_signals.push_back(index_signal);
+                }
+
+                size_t first_cell = value_signals.size();
+
+                if(output_schema_ == OutputSchema::kTyped){
+                    if(!no_empty_data){
+                        const std::string* value_string = std::get_if<std::string>(&value_signal.value);
+                        no_empty_data = value_signal.color != 0 || value_signal.id_problem != "" || value_string == nullptr || *value_string != "";
+                    }
+
+                    std::visit(WriteValueSignalsVariantOut{value_signals.emplace_back()}, value_signal.value);
+                    WriteValueSignalsVariantOut{value_signals.emplace_back()}.WriteNumber(value_signal.color);
+                    value_signals.emplace_back(value_signal.id_problem);
+                }else{
+                    std::string write_value = std::to_string(value_signal.color) + " ";
+                    write_value += std::visit(GetValueToStringSignalsVariantOut(), value_signal.value);
+                    if(value_signal.id_problem != "" && true){
+                        write_value += " ";
+                        write_value += value_signal.id_problem;
+                    }
+
+                    if(!no_empty_data && (write_value != "0 ") && (write_value != "0  ")){
+                        no_empty_data = true;
+                    }
+
+                    value_signals.emplace_back(std::move(write_value));
+                }
+
+                if(delta_recording){
+                    for(size_t cell = first_cell; cell < first_cell + count_marked_columns; ++cell){
+                        value_signals[cell].insert(value_signals[cell].begin(), kMarkerSentCell);
+                    }
+                }
+            }
+
+            value_signals.emplace_back(FormatTimestemp(snapshot.timestemp));
+        
+            bool need_write = (keyframe) ? no_empty_data : changed_row;
+
+            if(need_write){
+                output_batcher_.AddRow(output_tables_[table].index_batcher, std::move(value_signals));
+
+                //Запоминаются только отправленные значения: пропущенный сигнал в таблице остался прежним,
+                //иначе дрейф в пределах зоны нечувствительности терялся бы при изменении соседних столбцов
+                for(size_t index_signal : sent_signals){
+                    last_written[index_signal].output = data_table[index_signal];
+                    last_written[index_signal].written = true;
+                }
+            }
+
         }
-    }
 
-    json CalcServer::GenerateJSONForDebug(double time_calc, double step_calc){
+        if(delta_recording){
+            steps_since_keyframe_ = (steps_since_keyframe_ + 1) % keyframe_steps_;
+        }
 
-        json json_with_input_sig;
+        timer_serialization.reset();
 
-        for(const auto& function_dll : created_blocks_){
-            function_dll->GenerateDebugData(json_with_input_sig, time_calc, step_calc);
+        if(output_batcher_.EndStep()){
+            return FlushBatchOutputSignals();
         }
 
-        return json_with_input_sig;
+        return true;
     }
 
-    bool CalcServer::UpdateValueInputSignals(const std::string& name_file_inp){
-        std::ifstream in;
-
-        const std::string& name_file = (name_file_inp == "") ?  name_inp_file_json_ : name_file_inp;
+    bool CalcServer::IsChangedOutput(const WrittenSignalOutput& last, const OutputValue& current) const{
+        if(!last.written || last.output.color != current.color || last.output.id_problem != current.id_problem){
+            return true;
+        }
 
-        in.open(name_file);
-        if(!in.is_open()){
-            calc_server::logger.log("It is not possible to open a file with the name: " + name_file, Logger::LogLevel::kCritical);
+        const double* last_double = std::get_if<double>(&last.output.value);
+        const double* current_double = std::get_if<double>(&current.value);
 
-            std::cerr << "It is not possible to open a file with the name: " << name_file << std::endl;
+        if(last_double != nullptr && current_double != nullptr){
+            if(std::isnan(*last_double) || std::isnan(*current_double)){
+                return std::isnan(*last_double) != std::isnan(*current_double);
+            }
 
-            return false;
+            return std::abs(*current_double - *last_double) > output_deadband_;
         }
 
-        json dataIn;
-        dataIn = json::parse(in);
+        return last.output.value != current.value;
+    }
 
-        for(auto& [kks, set_value] : update_value_){
-            auto TargItem = dataIn.find(kks);
-            if(TargItem != dataIn.end()){
-                for(auto& input_sig_ptr : set_value){
-                    if(TargItem->is_number_integer()) {
-                        input_sig_ptr->value = static_cast<int>(TargItem.value());
-                    }else if(TargItem->is_number_float()) {
-                        input_sig_ptr->value = static_cast<double>(TargItem.value());
-                    }else if(TargItem->is_string()) {
-                        input_sig_ptr->value = static_cast<std::string>(TargItem.value());
-                    }
-                }
+    void CalcServer::SetOutputRecording(OutputRecording recording, size_t keyframe_steps, double deadband){
+        output_recording_ = recording;
+        keyframe_steps_ = std::max<size_t>(keyframe_steps, 1);
+        output_deadband_ = deadband;
+        steps_since_keyframe_ = 0;
+    }
 
-            }else if(kks.size() < 8 && kks[0] == 'K' && kks[1] == 'K' && kks[2] == 'S' && kks[3] == '_' && std::isdigit(kks[4]) && std::isdigit(kks[5]) && std::isdigit(kks[6])){
-                calc_server::logger.log("It is impossible to find a signal from KKS: " + kks, Logger::LogLevel::kError);
-            }
+    bool CalcServer::FlushOutputSignals(){
+        if(output_pipeline_ != nullptr){
+            output_pipeline_->Drain();
+        }
+
+        bool result = true;
+        {
+            std::lock_guard lock(mutex_output_writer_);
+            result = FlushBatchOutputSignals();
         }
 
-        in.close();
+        bool no_write_errors = !TakeNewOutputWriteErrors();
 
-        return true;
+        return result && no_write_errors;
     }
 
-    void CalcServer::SetOutputFile(std::string name){
-        name_inp_file_json_ = std::move(name);
+    bool CalcServer::TakeNewOutputWriteErrors(){
+        size_t count_errors = count_output_write_errors_.load(std::memory_order_relaxed);
+        return count_output_write_errors_reported_.exchange(count_errors, std::memory_order_relaxed) != count_errors;
     }
 
-    [[nodiscard]] bool CalcServer::ConnectDatabase(const std::string& name_connect){
+    bool CalcServer::FlushBatchOutputSignals(){
+        if(output_batcher_.Empty()){
+            return true;
+        }
 
-            using namespace std::literals;
-            std::ifstream json_model_file("ConfigDB.json");
+        ScopedTimer timer_enqueue(histogram_enqueue_);
 
-            if(!json_model_file.is_open()){
-                logger.log("The JSON file with the settings was not found: "s + "ConfigDB.json"s, Logger::LogLevel::kError);
-                return false;
-            }
-            
-            const json config_db = json::parse(json_model_file);
-            auto name_config = config_db.find(name_connect);
+        return output_batcher_.Flush([this](const std::string& table_name, const std::string& query, std::vector<std::string>&& values){
+            auto result_insert = request_tracker_.Enqueue(name_db_out_, query, std::move(values), Command::kInsert, table_name);
 
-            if(name_config == config_db.end()){
-                logger.log("No data was found for the configuration launch of the database. Name configuration: " + name_connect, Logger::LogLevel::kError);
+            if(result_insert.result_request != ResultRequest::kInProcessing){
+                logger.LogLazy(Logger::LogLevel::kCritical, [&table_name, &result_insert](){
+                    return "It is not possible to insert into the database " + table_name + "Code error: " + std::to_string(static_cast<int>(result_insert.result_request));
+                });
                 return false;
             }
 
-            auto data_connection = ConnectionInfo::ConnectionInfo::ConvertFromJSON(
-                *name_config
-            );
-
-            data_connection.id_connection = name_connect;
+            return true;
+        });
+    }
 
-            if(data_connection.dbname == ""){
-                logger.log(R"(The "DataBaseName" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
-                return false;
-            }
+    void CalcServer::SetOutputPipeline(bool asynchronous, size_t capacity, Backpressure backpressure){
+        if(output_pipeline_ != nullptr){
+            output_pipeline_->Drain();
+            output_pipeline_.reset();
+        }
 
-            if(data_connection.hostname == ""){
-                logger.log(R"(The "HostName" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
-                return false;
-            }
+        if(!asynchronous){
+            return;
+        }
 
-            if(data_connection.user == ""){
-                logger.log(R"(The "UserName" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
-                return false;
+        output_pipeline_ = std::make_unique<OutputPipeline<OutputSnapshot>>(
+            capacity,
+            backpressure,
+            [this](OutputSnapshot& snapshot){
+                std::lock_guard lock(mutex_output_writer_);
+                if(!WriteOutputSnapshot(snapshot)){
+                    ++count_output_write_errors_;
+                }
+            },
+            [this](){
+                //Сброс по интервалу, если шаги перестали приходить
+                std::lock_guard lock(mutex_output_writer_);
+                if(output_batcher_.IsFlushIntervalExpired() && !FlushBatchOutputSignals()){
+                    ++count_output_write_errors_;
+                }
             }
+        );
+    }
 
-            if(data_connection.password == ""){
-                logger.log(R"(The "Password" field was not found for the configuration )" + name_connect, Logger::LogLevel::kError);
-                return false;
-            }
+    PipelineCounters CalcServer::GetOutputPipelineCounters() const{
+        if(output_pipeline_ == nullptr){
+            return {};
+        }
 
-            if(!db_manager_.CreateConnectionDatabase(data_connection)){
-                logger.log( R"(Не удалось создать подключение к базе данных с настройками, указанными в "ConfigDB.json" для конфигурации: )" + name_connect, Logger::LogLevel::kCritical);
-                return false;
-            }
+        PipelineCounters counters = output_pipeline_->GetCounters();
+        counters.write_errors = count_output_write_errors_.load(std::memory_order_relaxed);
 
-            return true;
+        return counters;
     }
 
-    bool CalcServer::PreparingServerCalculation(){
+    void CalcServer::SetOutputSchema(OutputSchema schema){
+        output_schema_ = schema;
+    }
 
-        if(created_blocks_.empty()){
-            logger.log("There are no calculation blocks created. The necessary configuration data may not have loaded. Check the errors above.", Logger::LogLevel::kCritical);
-            return false;
+    std::vector<std::pair<std::string, std::string>> CalcServer::GetOutputColumns(const SignalOutput& signal, const SignalMaps& maps) const{
+        if(output_schema_ == OutputSchema::kText){
+            return {{signal.col_name, "character varying"}};
         }
 
-        UpdateListExistTable(name_db_coefficient_);
-
-        for(const auto& [name_table, content] : coefficients_){
-            if(!CheckTableExist(name_table, name_db_coefficient_)){
-                logger.log("Coefficients. The table does not exist in the database specified for connection: " + name_table, Logger::LogLevel::kCritical);
-                return false;
-            }
+        //Без типа в модели столбец строковый: в него без ошибок записывается значение любого типа
+        std::string type_column = "character varying";
+        if(auto type = maps.type_signals_output.find(&signal); type != maps.type_signals_output.end()){
+            type_column = GetSQLTypeSignal(type->second);
         }
 
-        return PreparingOutputTables() && PreparingRecordRequestCoef();
+        return {
+            {signal.col_name, std::move(type_column)},
+            {signal.col_name + "_color", "smallint"},
+            {signal.col_name + "_problem", "character varying"}
+        };
     }
 
+    std::string CalcServer::GetTimestempType() const{
+        return (output_schema_ == OutputSchema::kTyped) ? "timestamptz" : "character varying";
+    }
 
-    bool CalcServer::PreparingOutputTables(){
+    std::chrono::microseconds CalcServer::GetTimestempUnit() const{
+        switch(timestemp_resolution_){
+            case TimestempResolution::kMilliseconds:
+                return std::chrono::milliseconds(1);
+            case TimestempResolution::kMicroseconds:
+                return std::chrono::microseconds(1);
+            default:
+                return std::chrono::seconds(1);
+        }
+    }
 
-        UpdateListExistTable(name_db_out_);
+    std::string CalcServer::FormatTimestemp(std::chrono::microseconds timestemp) const{
+        auto seconds = std::chrono::floor<std::chrono::seconds>(timestemp);
+        std::string result = std::to_string(seconds.count());
 
-        for(const auto& [name_table, content] : signals_output_){
-            if(!CheckTableExist(name_table, name_db_out_)){
-                std::string query_create = "CREATE TABLE " + GetLowwerString(name_table) + " (" + "id bigserial, ";
+        if(timestemp_resolution_ == TimestempResolution::kSeconds){
+            return result;
+        }
 
-                if(name_table.back() != '9'){
-                    query_create += "timestemp character varying, ";
-                }
-                
-                bool first = true;
-                for (const auto& [name_sig, data_out] : content){
-                    
-                    if(first){
-                        query_create += data_out.col_name + " character varying";
-                        first = false;
-                        continue;
-                    }
+        //Дробная часть усекается до точности, а не округляется, чтобы не перейти в следующую секунду
+        auto unit = GetTimestempUnit();
+        std::string fraction = std::to_string((timestemp - seconds) / unit);
+        size_t digits = (timestemp_resolution_ == TimestempResolution::kMilliseconds) ? 3 : 6;
 
-                    query_create += ", " + data_out.col_name + " character varying";
-                }
-                
-                (name_table.back() == '6') ? query_create += ", status BOOLEAN NOT NULL DEFAULT false": query_create;
-                query_create += ")";
-                std::string id_connection = name_db_out_;
+        result += '.';
+        result.append(digits - fraction.size(), '0');
+        result += fraction;
 
-                auto ans_insert_queue = db_manager_.InsertRequestInQueue(
-                                                        id_connection.data(),
-                                                        query_create.data(),
-                                                        {},
-                                                        Command::kInsert,
-                                                        name_table
-                                                    );
+        return result;
+    }
 
-                if(ans_insert_queue.result_request != ResultRequest::kInProcessing){
-                    return false;
-                }
+    void CalcServer::SetOutputBatch(size_t max_steps, std::chrono::milliseconds flush_interval){
+        output_batcher_.SetBatch(max_steps, flush_interval);
+    }
 
-                while(db_manager_.AreRequestsInProgress()){std::this_thread::sleep_for(0.1s);}
-                std::this_thread::sleep_for(0.1s);
+    //Имя столбца, в котором запрос возвращает версию таблицы
+    constexpr const char* kColumnCoefficientVersion = "calc_server_version";
 
-                logger.log("A table with the name has been created: " + name_table, Logger::LogLevel::kInfo);
+    void CalcServer::SetCoefficientVersionColumn(std::string name_column){
+        coefficient_version_column_ = GetLowwerString(name_column);
+    }
 
-            }else{
-                std::string query_select = "SELECT column_name FROM information_schema.columns WHERE table_name = '" + name_table + "' AND table_schema = 'public'";
-
-                auto ans_insert_queue = db_manager_.InsertRequestInQueue(
-                                                    name_db_out_.data(),
-                                                    query_select.data(),
-                                                    {},
-                                                    Command::kSelect,
-                                                    name_table
-                                                );
-
-                if(ans_insert_queue.result_request != ResultRequest::kInProcessing){
-                    logger.log("Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kCritical);
-                    return false;
-                }
+    std::string CalcServer::GetCoefficientSelect(const std::string& table_name) const{
+        if(coefficient_version_column_.empty()){
+            return "SELECT * FROM " + GetLowwerString(table_name);
+        }
 
-                while(db_manager_.AreRequestsInProgress()){std::this_thread::sleep_for(0.1s);}
+        //Максимальная версия считается сервером БД, чтобы не сравнивать значения разных типов на клиенте
+        return "SELECT *, (max(" + coefficient_version_column_ + ") OVER ())::text AS " + kColumnCoefficientVersion
+                + " FROM " + GetLowwerString(table_name);
+    }
 
-                auto exist_column = WaitWorkThreadCheckTableNames(11, ans_insert_queue.id_request, db_manager_);
-                
-                if(exist_column.id_request == -1){
-                    return false;
-                }
+    void CalcServer::AddCoefficientRequests(const std::string& table_name){
+        std::string select = GetCoefficientSelect(table_name);
 
-                std::string quere_request_new_column;
-                std::string type_value = " character varying";
-                bool first = true;
+        if(!coefficient_version_column_.empty()){
+            name_table_to_request_select_changed_[table_name] = select + " WHERE " + coefficient_version_column_ + " > $1";
+        }
 
-                auto& map_column = exist_column.code_to_map_field_value;
+        name_table_to_request_select_[table_name] = std::move(select);
+    }
 
-                for(const auto& output_signal : content){
-                    if(map_column.find(GetLowwerString(output_signal.second.col_name)) == map_column.end()){
-                        if(first){
-                            quere_request_new_column = " ADD COLUMN " + output_signal.second.col_name + type_value;
-                            first = false;
-                            continue;
-                        }
-                        quere_request_new_column += ", ADD COLUMN " + output_signal.second.col_name + type_value;
-                    }
-                }
+    bool CalcServer::PreparingRecordRequestCoef(){
 
-                std::string quere = "ALTER TABLE " + name_table;
-                (!map_column.contains(("id"))) ?
-                            (quere_request_new_column == "") ? quere_request_new_column += " ADD COLUMN id bigserial" : quere_request_new_column += ", ADD COLUMN id bigserial" :
-                            quere_request_new_column ;
+        StopCoefficientRefresher();
+        coefficients_prepared_ = false;
 
-                (!map_column.contains(("timestemp"))) ?
-                            (quere_request_new_column == "") ? quere_request_new_column += " ADD COLUMN timestemp character varying" : quere_request_new_column += ", ADD COLUMN timestemp character varying" :
-                            quere_request_new_column ;
+        name_table_to_request_select_changed_.clear();
+        name_table_to_coefficient_version_.clear();
 
-                (name_table.back() == '6' && (!map_column.contains(("status")))) ?
-                            (quere_request_new_column != "") ?
-                                quere_request_new_column += ", ADD COLUMN status BOOLEAN NOT NULL DEFAULT false":
-                                quere_request_new_column += " ADD COLUMN status BOOLEAN NOT NULL DEFAULT false":
-                            quere_request_new_column;
-                quere += quere_request_new_column;
+        for(auto& [table_name, data_table] : maps_.coefficients){
+            AddCoefficientRequests(table_name);
+        } 
 
-                if(quere != "ALTER TABLE " + name_table){
-                    std::string id_connection = name_db_out_;
+        if(!UpdateCoefficients(true)){
+            return false;
+        }
 
-                    auto ans_insert_queue = db_manager_.InsertRequestInQueue(
-                                                            id_connection.data(),
-                                                            quere.data(),
-                                                            {},
-                                                            Command::kInsert,
-                                                            name_table
-                                                        );
+        coefficients_prepared_ = true;
+        StartCoefficientRefresher();
 
-                    if(ans_insert_queue.result_request != ResultRequest::kInProcessing){
-                        logger.log("Request processing error : " + quere + " in table: " + name_table, Logger::LogLevel::kCritical);
-                        return false;
-                    }
+        return true;
+    }
 
-                    while(db_manager_.AreRequestsInProgress()){std::this_thread::sleep_for(0.1s);}
-                    std::this_thread::sleep_for(0.2s);
+    [[nodiscard]] bool CalcServer::UpdateCoefficients(bool need_wait_update){
 
-                    logger.log("Successful request processing: " + quere_request_new_column + " in table: " + name_table, Logger::LogLevel::kInfo);
-                }
-            }
+        if(coefficient_refresher_.joinable()){
+            ApplyPendingCoefficients();
+            return true;
         }
         
-        return PreparingRecordRequestOut();
-    }
-
-    bool CalcServer::PreparingRecordRequestOut(){
-
-        for(const auto& [table_name, data_table] : signals_output_){
-            bool first = true;
-            std::string quere_request_column = "INSERT INTO " + GetLowwerString(table_name) + " (";;
-            std::string quere_request_placeholder = "(";
-            size_t num_place = 1;
+        for(auto& [table_name, data_table] : maps_.coefficients){
 
-            for(const auto& [name_signal, value_signal] : data_table){
-                if(name_signal == "timestemp"){
-                    continue;
-                }
+            //Предыдущее обновление таблицы ещё не пришло
+            if(select_coefficients_wait_.contains(table_name)){
+                continue;
+            }
 
-                if(first){
-                    quere_request_column += value_signal.col_name;
-                    quere_request_placeholder += "$" + std::to_string(num_place++);
-                    first = false;
-                    continue;
-                }
+            const std::string* query = &name_table_to_request_select_[table_name];
+            std::vector<std::string> values;
 
-                quere_request_column += ", " + value_signal.col_name;
-                quere_request_placeholder += ", $" + std::to_string(num_place++);
+            if(auto version = name_table_to_coefficient_version_.find(table_name); version != name_table_to_coefficient_version_.end()){
+                query = &name_table_to_request_select_changed_[table_name];
+                values.push_back(version->second);
             }
 
-            quere_request_column += ", " + std::string{"timestemp"};
-            quere_request_placeholder += ", $" + std::to_string(num_place++);
+            auto request_select = request_tracker_.Submit(name_db_coefficient_, *query, std::move(values), Command::kSelect, table_name);
 
-            quere_request_column += ")";
-            quere_request_placeholder += ")";
+            if(!request_select.IsValid()){
+                logger.log("Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kCritical);
+                return false;
+            }
 
-            name_table_to_request_insert_[table_name] = {std::move(quere_request_column) + " VALUES " + std::move(quere_request_placeholder)};
+            select_coefficients_wait_.emplace(table_name, std::move(request_select));
+        } 
 
-            #ifdef DEBUG
-                logger.log("Request insert: " + name_table_to_request_insert_[table_name] + " in table: " + table_name);
-            #endif
-        }           
+        CheckUpdateValue(need_wait_update);
 
         return true;
 
     }
 
-    bool CalcServer::WriteOutputSignalsToDatabase(){
-        
-        for(const auto& [table_name, data_table] : signals_output_){
+    void CalcServer::ParseCoefficientsFromSelect(   ResultInsertRequest& result_select,
+                                                    std::unordered_map<const Coefficient*, CoefficientRow>* published,
+                                                    CoefficientSnapshot& snapshot
+    ){
+        std::string table_name(result_select.name_table);
 
-            bool no_empty_data = false;
-            std::vector<std::string> value_signals;
-            value_signals.reserve(data_table.size());
+        auto table = maps_.coefficients.find(table_name);
+        if(table == maps_.coefficients.end()){
+            return;
+        }
 
-            for(const auto& [name_signal, value_signal] : data_table){
+        std::string version;
+        ParseCoefficientRows(result_select, table->second, published, snapshot, version);
 
-                if(name_signal == "timestemp"){
-                    continue;
-                }                
+        if(!version.empty()){
+            name_table_to_coefficient_version_[table_name] = std::move(version);
+        }
+    }
 
-                std::string write_value = std::to_string(static_cast<int>(value_signal.highlight_value.current_color)) + " ";
-                write_value += std::visit(GetValueToStringSignalsVariantOut(), value_signal.value);
-                if(value_signal.id_problem != "" && true){
-                    write_value += " ";
-                    write_value += value_signal.id_problem;
+    void CalcServer::ParseCoefficientRows(  ResultInsertRequest& result_select,
+                                            const MapNameCoefficientToValue& table_content,
+                                            std::unordered_map<const Coefficient*, CoefficientRow>* published,
+                                            CoefficientSnapshot& snapshot,
+                                            std::string& version
+    ) const{
+        std::string table_name(result_select.name_table);
+
+        //Разбираются только пришедшие строки: при выборке по версии это изменившиеся коэффициенты
+        for(auto& [name_signal, fields] : result_select.code_to_map_field_value){
+            if(!coefficient_version_column_.empty()){
+                if(auto version_row = fields.find(kColumnCoefficientVersion); version_row != fields.end()){
+                    version = version_row->second;
                 }
+            }
 
-                if(!no_empty_data && (write_value != "0 ") && (write_value != "0  ")){
-                    no_empty_data = true;
-                }
+            auto coefficient = table_content.find(name_signal);
+            if(coefficient == table_content.end()){
+                continue;
+            }
+
+            Coefficient& data_signal = *coefficient->second;
 
-                value_signals.emplace_back(std::move(write_value));
+            //Значения коэффициента шаг меняет только при применении снимка, поэтому поток обновления
+            //сравнивает со своей копией, а не с data_row
+            CoefficientRow* current = &data_signal.data_row;
+            if(published != nullptr){
+                auto [known, inserted] = published->try_emplace(&data_signal);
+                if(inserted){
+                    known->second = data_signal.data_row;
+                }
+                current = &known->second;
             }
 
-            value_signals.emplace_back(std::move(std::to_string(timestemp_.count())));
-        
+            CoefficientUpdate update{&data_signal, *current};
+            bool changed = false;
 
-            if(no_empty_data){
-                auto result_insert = db_manager_.InsertRequestInQueue(
-                                            name_db_out_.data(),
-                                            name_table_to_request_insert_[table_name].data(),
-                                            std::move(value_signals),
-                                            Command::kInsert,
-                                            table_name
-                                        );
-
-                if(result_insert.result_request != ResultRequest::kInProcessing){
-                    logger.log("It is not possible to insert into the database " + table_name + "Code error: " + std::to_string(static_cast<int>(result_insert.result_request)), Logger::LogLevel::kCritical);
-                    return false;
+            for(auto& [name_row, value_row] : update.data_row){
+                auto field = fields.find(name_row);
+                if(field == fields.end()){
+                    ReportMissingCoefficientColumn(table_name, name_row, name_signal);
+                    continue;
+                }
+
+                std::string& str = field->second;
+                char* end;
+
+                // Попробуем преобразовать в число с плавающей точкой
+                double d = std::strtod(str.c_str(), &end);
+
+                if(*end == '\0'){
+                    changed |= !(std::holds_alternative<double>(value_row) && std::get<double>(value_row) == d);
+                    value_row = d;
+                }else{
+                    changed |= !(std::holds_alternative<std::string>(value_row) && std::get<std::string>(value_row) == str);
+                    value_row = str;
                 }
             }
 
+            if(changed){
+                if(published != nullptr){
+                    *current = update.data_row;
+                }
+                snapshot.push_back(std::move(update));
+            }
         }
+    }
 
-        return true;
+    void CalcServer::ReportMissingCoefficientColumn(const std::string& table_name, const std::string& name_row, const std::string& name_signal) const{
+        {
+            std::lock_guard lock(mutex_missing_coefficient_columns_);
+            if(!missing_coefficient_columns_.insert(table_name + '\0' + name_row).second){
+                return;
+            }
+        }
+
+        logger.log("There is no column \"" + name_row + "\" in table " + table_name + " for coefficient \"" + name_signal + "\". The message is not repeated for this column", Logger::LogLevel::kWarning);
     }
 
-    bool CalcServer::PreparingRecordRequestCoef(){
+    void CalcServer::ApplyCoefficientSnapshot(CoefficientSnapshot& snapshot){
+        for(auto& update : snapshot){
+            update.target->data_row = std::move(update.data_row);
+            changed_coefficients_.push_back(update.target);
+        }
+    }
 
-        for(auto& [table_name, data_table] : coefficients_){
-            name_table_to_request_select_[table_name] = "SELECT * FROM " + GetLowwerString(table_name) ;
-        } 
+    void CalcServer::ApplyPendingCoefficients(){
+        std::unique_ptr<CoefficientSnapshot> snapshot(pending_coefficients_.exchange(nullptr, std::memory_order_acquire));
 
-        return UpdateCoefficients(true);
+        if(snapshot != nullptr){
+            ApplyCoefficientSnapshot(*snapshot);
+        }
     }
 
-    [[nodiscard]] bool CalcServer::UpdateCoefficients(bool need_wait_update){
-        
-        for(auto& [table_name, data_table] : coefficients_){
-
-            auto result_select = db_manager_.InsertRequestInQueue(
-                                                    name_db_coefficient_.data(),
-                                                    name_table_to_request_select_[table_name].data(),
-                                                    {},
-                                                    Command::kSelect,
-                                                    table_name
-                                            );
+    void CalcServer::SetCoefficientRefresh(std::chrono::milliseconds period){
+        StopCoefficientRefresher();
 
-            if(result_select.result_request != ResultRequest::kInProcessing){
-                logger.log("Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kCritical);
-                return false;
-            }
+        coefficient_refresh_period_ = period;
 
-            id_request_select_wait_.insert(result_select.id_request);
-        } 
+        if(coefficients_prepared_){
+            StartCoefficientRefresher();
+        }
+    }
 
-        CheckUpdateValue(need_wait_update);
+    void CalcServer::StartCoefficientRefresher(){
+        if(coefficient_refresh_period_.count() <= 0 || coefficient_refresher_.joinable()){
+            return;
+        }
 
-        return true;
+        //Ожидания синхронного обновления больше никто не проверит
+        CheckUpdateValue(true);
 
+        stop_coefficient_refresher_ = false;
+        coefficient_refresher_ = std::thread(&CalcServer::CoefficientRefreshLoop, this);
     }
 
-    void CalcServer::CheckUpdateValue(bool waiting_all){
-        
-        if(waiting_all){
-            while(db_manager_.AreRequestsInProgress()){
-                std::this_thread::sleep_for(0.1s);
-            }
+    void CalcServer::StopCoefficientRefresher(){
+        if(!coefficient_refresher_.joinable()){
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex_coefficient_refresher_);
+            stop_coefficient_refresher_ = true;
         }
+        cv_coefficient_refresher_.notify_all();
+        coefficient_refresher_.join();
+
+        //Последний снимок применяется, чтобы не потерять изменения
+        ApplyPendingCoefficients();
+    }
 
-        //#ifdef DEBUG
-            auto start = std::chrono::system_clock::now();
-        //#endif
+    void CalcServer::CoefficientRefreshLoop(){
+        std::unordered_map<const Coefficient*, CoefficientRow> published;
 
-        do{
-            std::vector<int> remove_id;
+        auto is_stopped = [this](){
+            std::lock_guard lock(mutex_coefficient_refresher_);
+            return stop_coefficient_refresher_;
+        };
 
-            for(int id : id_request_select_wait_){
-                auto exist_table = WaitWorkThreadCheckTableNames(50, id, db_manager_);
-            
-                if(exist_table.id_request != -1){
-                    #ifdef DEBUG
-                        auto start_app = std::chrono::system_clock::now();
-                    #endif
+        while(true){
+            {
+                std::unique_lock lock(mutex_coefficient_refresher_);
+                if(cv_coefficient_refresher_.wait_for(lock, coefficient_refresh_period_, [this](){ return stop_coefficient_refresher_; })){
+                    return;
+                }
+            }
 
-                    for(auto& [name_signal, data_signal] : coefficients_[std::string(exist_table.name_table)]){
-                        for(auto& [name_row, value_row] : data_signal.data_row){
-                            std::string& str = exist_table.code_to_map_field_value.at(name_signal).at(name_row);
-                            char* end;
+            std::vector<RequestHandle> requests;
 
-                            // Попробуем преобразовать в число с плавающей точкой
-                            double d = std::strtod(str.c_str(), &end);
-                            (*end == '\0') ? value_row = d : value_row = str;
+            for(auto& [table_name, data_table] : maps_.coefficients){
+                const std::string* query = &name_table_to_request_select_[table_name];
+                std::vector<std::string> values;
 
-                        }
+                if(auto version = name_table_to_coefficient_version_.find(table_name); version != name_table_to_coefficient_version_.end()){
+                    query = &name_table_to_request_select_changed_[table_name];
+                    values.push_back(version->second);
+                }
+
+                auto request_select = request_tracker_.Submit(name_db_coefficient_, *query, std::move(values), Command::kSelect, table_name);
+
+                if(!request_select.IsValid()){
+                    logger.log("Coefficient refresh. Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kError);
+                    continue;
+                }
+
+                requests.push_back(std::move(request_select));
+            }
+
+            auto start_reload = std::chrono::steady_clock::now();
+            auto snapshot = std::make_unique<CoefficientSnapshot>();
+
+            for(auto& request : requests){
+                //Ожидание прерывается остановкой сервера
+                auto start_wait = std::chrono::steady_clock::now();
+                while(!request.IsReady() && std::chrono::steady_clock::now() - start_wait < kTimeoutRequest){
+                    if(is_stopped()){
+                        return;
                     }
+                    (void)request.Wait(std::chrono::milliseconds(10));
+                }
 
-                    remove_id.push_back(id);
-                    #ifdef DEBUG
-                        std::cout << "Update coef table: " << exist_table.name_table <<std::endl;
-                        std::cout << "Update time: "<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - start_app).count() <<std::endl;
-                    #endif
+                auto exist_table = request.Wait(std::chrono::milliseconds(0));
+                if(exist_table.id_request == -1){
+                    logger.log("Coefficient refresh. Coefficients were not received from the database", Logger::LogLevel::kError);
+                    continue;
                 }
+
+                ParseCoefficientsFromSelect(exist_table, &published, *snapshot);
+            }
+
+            if(LatencyHistogram* histogram = histogram_coefficient_reload_; histogram != nullptr){
+                histogram->Record(std::chrono::steady_clock::now() - start_reload);
+            }
+
+            if(snapshot->empty()){
+                continue;
             }
 
-            if(db_manager_.GetSizeQueueSelect() == 0){
-                id_request_select_wait_.clear();
+            //Если шаг ещё не забрал предыдущий снимок, новые значения дописываются к нему
+            std::unique_ptr<CoefficientSnapshot> not_applied(pending_coefficients_.exchange(nullptr, std::memory_order_acq_rel));
+            if(not_applied != nullptr){
+                not_applied->insert(not_applied->end(), std::make_move_iterator(snapshot->begin()), std::make_move_iterator(snapshot->end()));
+                snapshot = std::move(not_applied);
             }
 
-            for(int id_remove : remove_id){
-                id_request_select_wait_.erase(id_remove);
+            pending_coefficients_.store(snapshot.release(), std::memory_order_release);
+        }
+    }
+
+    void CalcServer::CheckUpdateValue(bool waiting_all){
+
+        ScopedTimer timer_reload((select_coefficients_wait_.empty()) ? nullptr : histogram_coefficient_reload_);
+
+        for(auto request = select_coefficients_wait_.begin(); request != select_coefficients_wait_.end();){
+            if(!waiting_all && !request->second.IsReady()){
+                ++request;
+                continue;
             }
 
-        }while(waiting_all && !id_request_select_wait_.empty());
+            auto exist_table = request->second.Wait(kTimeoutRequest);
+        
+            if(exist_table.id_request != -1){
+                #ifdef DEBUG
+                    auto start_app = std::chrono::system_clock::now();
+                #endif
+
+                CoefficientSnapshot snapshot;
+                ParseCoefficientsFromSelect(exist_table, nullptr, snapshot);
+                ApplyCoefficientSnapshot(snapshot);
+
+                #ifdef DEBUG
+                    std::cout << "Update coef table: " << exist_table.name_table <<std::endl;
+                    std::cout << "Update time: "<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - start_app).count() <<std::endl;
+                #endif
+            }else{
+                logger.log("Coefficients were not received from table: " + request->first, Logger::LogLevel::kError);
+            }
 
-        //#ifdef DEBUG
-            std::cout << "Update coef total: "<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - start).count() <<std::endl;
-        //#endif
+            request = select_coefficients_wait_.erase(request);
+        }
     }
 
     bool CalcServer::CheckTableExist(const std::string& name_table, const std::string& name_connection) const{
-        return (name_db_to_exist_tables_.at(name_connection).count(name_table) > 0 || name_db_to_exist_tables_.at(name_connection).count(GetLowwerString(name_table)) > 0);
+        return CheckTableExist(name_table, name_db_to_exist_tables_.at(name_connection));
+    }
+
+    bool CalcServer::CheckTableExist(const std::string& name_table, const std::set<std::string>& exist_tables){
+        return (exist_tables.count(name_table) > 0 || exist_tables.count(GetLowwerString(name_table)) > 0);
     }
 
     bool CalcServer::UpdateListExistTable(const std::string& name_connection){
-            std::string query = "SELECT table_name FROM information_schema.tables WHERE table_schema = 'public' AND table_type = 'BASE TABLE'";
+        return UpdateListExistTable(name_connection, name_db_to_exist_tables_[name_connection]);
+    }
 
-            std::string id_connection = name_connection;
+    bool CalcServer::UpdateListExistTable(const std::string& name_connection, std::set<std::string>& exist_tables){
+            std::string query = "SELECT table_name FROM information_schema.tables WHERE table_schema = 'public' AND table_type = 'BASE TABLE'";
 
-            auto ans_insert_queue = db_manager_.InsertRequestInQueue(
-                                                    id_connection.data(),
-                                                    query.data(),
-                                                    {},
-                                                    Command::kSelect,
-                                                    "All_table"
-                                                );
+            auto request_select = request_tracker_.Submit(name_connection, query, {}, Command::kSelect, "All_table");
 
-            if(ans_insert_queue.result_request != ResultRequest::kInProcessing){
+            if(!request_select.IsValid()){
                 logger.log("Check the \"DatabaseLog.txt\" file for more information", Logger::LogLevel::kCritical);
                 return false;
             }
 
-            while(db_manager_.AreRequestsInProgress()){std::this_thread::sleep_for(0.1s);}
-
-            auto exist_table = WaitWorkThreadCheckTableNames(11, ans_insert_queue.id_request, db_manager_);
+            auto exist_table = request_select.Wait(kTimeoutRequest);
             
             if(exist_table.id_request == -1){
                 return false;
             }
             
-            name_db_to_exist_tables_[name_connection].clear();
+            exist_tables.clear();
             for(auto& [name_row, data_value] : exist_table.code_to_map_field_value){
-                name_db_to_exist_tables_[name_connection].insert(name_row); 
+                exist_tables.insert(name_row); 
             }
 
             return true;
@@ -877,10 +3019,10 @@ namespace calc_server{
                 for(const auto& [name_table, content_table] : server.GetOutputSignals()){
                     for(const auto& [name_signals, value_signals] : content_table){
                         json_array.push_back(json::object({
-                                                            {"code", value_signals.code},
-                                                            {"col_name", value_signals.col_name},
-                                                            {"table_name", value_signals.table_name},
-                                                            {"value", std::visit(GetValueToStringSignalsVariantOut(), value_signals.value)}
+                                                            {"code", value_signals->code},
+                                                            {"col_name", value_signals->col_name},
+                                                            {"table_name", value_signals->table_name},
+                                                            {"value", std::visit(GetValueToStringSignalsVariantOut(), value_signals->value)}
                                                         })
                                             );
 
@@ -1,37 +1,104 @@
 #pragma once
 
+#include <charconv>
+#include <functional>
+#include <limits>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
 
 #include "calcelement.h"
 #include "DatabaseManagements.h"
+#include "DatabaseClient.h"
 #include "LoadData.h"
 #include "Logger.h"
+#include "AsyncLogger.h"
+#include "InputFileWatcher.h"
+#include "KKSSlotTable.h"
+#include "SharedMemoryInput.h"
+#include "ReplayReader.h"
+#include "BlockGraph.h"
+#include "ThreadPool.h"
+#include "StepScheduler.h"
+#include "OutputBatcher.h"
+#include "OutputPipeline.h"
+#include "RequestTracker.h"
+#include "SignalStore.h"
+#include "Metrics.h"
+#include "ModelSnapshot.h"
 
 namespace calc_server{
     
     using namespace database_managements;
+    using namespace database_client;
     using namespace logger;
     using namespace load_data;
     using namespace calc_element;
+    using namespace input_signals;
+    using namespace scheduling;
+    using namespace output_writer;
+    using namespace request_tracker;
+    using namespace signal_store;
+    using namespace metrics;
+    using namespace model_snapshot;
 
     using DynamicLibrary = load_data::DynamicLibrary;
     using MapKKSToSetPtr = std::unordered_map<std::string, std::set<SignalInput*>>;
 
-    using MapNameInputSignalToData =            std::unordered_map<std::string, SignalInput>;
-    using MapNameCoefficientToValue =           std::unordered_map<std::string, Coefficient>;
+    //Сами объекты лежат в SignalStore, карты - поиск по коду и таблице
+    using MapNameInputSignalToData =            std::unordered_map<std::string, SignalInput*>;
+    using MapNameCoefficientToValue =           std::unordered_map<std::string, Coefficient*>;
     using MapNameTableToValueCoefficients =     std::unordered_map<std::string, MapNameCoefficientToValue>;
-    using MapNameOutputSignalToVlaue =          std::unordered_map<std::string, SignalOutput>;
+    using MapNameOutputSignalToVlaue =          std::unordered_map<std::string, SignalOutput*>;
     using MapNameTableToValueOutputSignals =    std::unordered_map<std::string, MapNameOutputSignalToVlaue>;
 
     using json = nlohmann::json;
     
-    static Logger logger("CalcServerLogger.txt", true);
+    //Один журнал на процесс, запись в файл в фоновом потоке, пока существует хотя бы один CalcServer
+    inline async_logger::AsyncLogger logger("CalcServerLogger.txt", true);
+
+    //Значение выходного сигнала на момент окончания шага
+    struct OutputValue{
+        decltype(SignalOutput::value) value;
+        int color = 0;
+        std::string id_problem;
+    };
+
+    struct OutputSnapshot{
+        std::chrono::microseconds timestemp{0};
+        std::vector<std::vector<OutputValue>> tables;
+    };
+
+    //Сигналы, с которыми связан блок расчёта. Хранится параллельно created_blocks_.
+    struct BlockWiring{
+        std::string type;
+        std::vector<const SignalInput*> inputs;
+        std::vector<const Coefficient*> coefficients;
+        std::vector<const SignalOutput*> outputs;
+
+        //Блок выполняется на каждом шаге и в инкрементальном режиме (внутреннее состояние, зависимость от времени)
+        bool always_process = false;
+
+        //Хеш файла модели и описания блока, по нему блок находится при перезагрузке моделей
+        uint64_t source_key = 0;
+
+        //Метка блока в метриках, одинаковая между перезапусками (см. GetBlockName)
+        std::string name;
+    };
 
     class CalcServer{
     public:
+        enum class InputMode{
+            kFullReload,        //Файл входных сигналов читается целиком на каждом шаге
+            kWatchChanges,      //Файл читается только если изменился, обновляются только изменившиеся KKS
+            kSharedMemory       //Значения читаются из сегмента разделяемой памяти (SharedMemoryLayout.h)
+        };
+
         CalcServer();
 
+        //Работа с другой реализацией базы данных (например, находящейся в процессе для замеров)
+        explicit CalcServer(std::unique_ptr<IDatabaseClient> db_client);
+
         ~CalcServer();
 
         CalcServer(const CalcServer& other) = delete;
@@ -39,12 +106,193 @@ namespace calc_server{
         CalcServer(const CalcServer&& other) = delete;
         CalcServer& operator=(const CalcServer&& other) = delete;
 
+        using CreateFunction = std::unique_ptr<ICalcElement> (*)(MapNameInputSignalToDataPtr&& inp,
+                                                        MapNameTableToValueCoefficientsPtr&& coef,
+                                                        MapNameTableToValueOutputSignalsPtr&& output
+        );
+
         void LoadDLLFunctions(const fs_path& path);
+
+        //Тип блока, встроенный в приложение, без DLL. Имеет приоритет над DLL с тем же типом.
+        //Вызывается до CreateBlocksFromJSON.
+        void RegisterBlockType(const std::string& type, CreateFunction create_block);
+
         void CreateBlocksFromJSON(const fs_path& path);
+
+        enum class ReloadState{
+            kIdle,          //Перезагрузки нет или она применена
+            kPreparing,     //Модели и плагины загружаются в фоне
+            kReady,         //Новый набор блоков будет подставлен перед следующим шагом
+            kFailed         //Ошибка в моделях, плагинах или таблицах, расчёт продолжается с текущим набором
+        };
+
+        //Перезагрузка моделей из каталогов CreateBlocksFromJSON и плагинов из каталогов LoadDLLFunctions.
+        //Файлы читаются, сигналы регистрируются, новые и изменённые блоки создаются, выходные таблицы
+        //и столбцы создаются, а новые коэффициенты читаются в фоновом потоке. Готовый набор подставляется
+        //перед шагом CalcOneStep, StartRealTime или RunReplay либо в начале CalcSteps. Блоки с неизменными
+        //описанием и плагином переносятся вместе с состоянием. Плагин считается изменённым по размеру и времени файла.
+        //Вызывается после PreparingServerCalculation; false - перезагрузка уже идёт или моделей нет.
+        //Функции Create новых блоков выполняются параллельно шагам расчёта.
+        [[nodiscard]] bool RequestReload();
+
+        ReloadState GetReloadState() const{
+            return reload_state_.load(std::memory_order_acquire);
+        }
+
+        //Файл снимка загруженных моделей и списков таблиц БД. Вызывается до CreateBlocksFromJSON.
+        //Если файлы моделей, плагины и настройки не изменились, модели читаются из снимка без разбора JSON,
+        //а PreparingServerCalculation не обращается к information_schema и не меняет схему таблиц.
+        //Иначе снимок перестраивается после успешного PreparingServerCalculation.
+        void SetModelSnapshot(fs_path path);
+
+        //Число потоков для разбора файлов моделей и вызовов Create в CreateBlocksFromJSON. 1 - последовательно.
+        //При count_threads > 1 функции Create всех типов блоков должны быть потокобезопасны.
+        void SetCountLoadThreads(size_t count_threads);
         [[nodiscard]] bool PreparingServerCalculation();
         [[nodiscard]] bool CalcOneStep(double current_time, double step_calc = 1);
         [[nodiscard]] json GenerateJSONForDebug(double time_calc, double step_calc = 1);
+
+        struct ReplayResult{
+            size_t steps = 0;
+            bool completed = false;     //Файл прочитан до конца (или до max_steps) и выходные сигналы записаны
+        };
+
+        //Расчёт по записанному потоку входных сигналов (JSON Lines, строка на шаг) без ожидания реального времени.
+        //timestemp увеличивается на step_calc за шаг начиная со значения, заданного SetTimestemp.
+        //max_steps == 0 - до конца файла.
+        [[nodiscard]] ReplayResult RunReplay(const fs_path& path, double start_time = 0, double step_calc = 1, size_t max_steps = 0);
+
+        //Значения входных сигналов одного шага для CalcSteps. Слот KKS находится один раз до расчёта.
+        class StepInput{
+        public:
+            explicit StepInput(KKSSlotTable& table) : table_(table){}
+
+            //KKSSlotTable::kNotFound, если KKS не используется моделями
+            int FindSlot(std::string_view kks) const{
+                return table_.FindSlot(kks);
+            }
+
+            void SetValue(int slot, int value){
+                table_.SetValue(slot, value);
+            }
+
+            void SetValue(int slot, double value){
+                table_.SetValue(slot, value);
+            }
+
+            void SetValue(int slot, std::string_view value){
+                table_.SetValue(slot, value);
+            }
+
+            //Объект {"KKS": значение, ...}, как во входном файле
+            [[nodiscard]] bool ParseJSON(std::string_view content){
+                return table_.ParseJSON(content);
+            }
+
+        private:
+            KKSSlotTable& table_;
+        };
+
+        //Заполняет значения шага index_step, false - входные данные получить не удалось
+        using InputProvider = std::function<bool(size_t index_step, double current_time, StepInput& input)>;
+        //Вызывается после шага, true - остановить расчёт
+        using StopPredicate = std::function<bool(size_t index_step, double current_time)>;
+
+        enum class StepStatus{
+            kOk,
+            kInputError,
+            kCalcError
+        };
+
+        struct StepsResult{
+            std::vector<StepStatus> steps;      //По одному на выполненный шаг, ошибка - всегда последний
+            bool stopped = false;               //Остановлен stop_predicate
+            bool flushed = false;               //Накопленные выходные сигналы поставлены в очередь БД
+        };
+
+        //Выполняет до count шагов подряд начиная с start_time. Строки выходных таблиц за все шаги копятся
+        //и пишутся полными многострочными INSERT, остаток - в конце вызова.
+        //Без input_provider значения читаются из настроенного источника, как в CalcOneStep.
+        [[nodiscard]] StepsResult CalcSteps(double start_time, double step_calc, size_t count, const InputProvider& input_provider = {}, const StopPredicate& stop_predicate = {});
+
+        //Выходной сигнал для проверки в StopPredicate. Указатель действителен до перезагрузки моделей.
+        const SignalOutput* FindSignalOutput(const std::string& code, const std::string& table_name = "") const{
+            return GetSignalOutput(code, table_name);
+        }
+
+        //Шаги в отдельном потоке с периодом settings.period по монотонным часам. current_time шага -
+        //start_time + index * period, timestemp - срок шага по расписанию. Пока расписание запущено,
+        //CalcOneStep, CalcSteps и RunReplay не вызываются.
+        [[nodiscard]] bool StartRealTime(const StepScheduler::Settings& settings, double start_time = 0);
+        void StopRealTime();
+
+        //Выполненные и пропущенные шаги, превышения периода, наибольшее опоздание начала шага
+        StepScheduler::Counters GetRealTimeCounters() const{
+            return step_scheduler_.GetCounters();
+        }
+
         void SetOutputFile(std::string name);
+        void SetInputMode(InputMode mode);
+        void SetInputSharedMemory(std::string name_segment);
+
+        //Число потоков для расчёта блоков. 1 - последовательный расчёт в порядке загрузки.
+        void SetCountThreads(size_t count_threads);
+
+        //Инкрементальный режим: выполняются только блоки, у которых изменились входные сигналы или коэффициенты,
+        //и блоки, зависящие от них по выходным сигналам. Блок исключается из режима полем "AlwaysProcess": true
+        //в модели или через SetAlwaysProcessType для всех блоков типа.
+        void SetIncrementalMode(bool incremental);
+        void SetAlwaysProcessType(const std::string& type_block);
+
+        enum class OutputSchema{
+            kText,      //Все столбцы character varying, значение сигнала записывается строкой "цвет значение проблема"
+            kTyped      //На сигнал три столбца: значение (тип по полю "type" сигнала в модели), цвет (smallint), проблема; timestemp - timestamptz
+        };
+
+        //Вызывается до PreparingServerCalculation
+        void SetOutputSchema(OutputSchema schema);
+
+        enum class OutputRecording{
+            kFull,      //Строка таблицы пишется на каждом шаге
+            kDelta      //Строка пишется, только если изменился хотя бы один сигнал, неизменившиеся сигналы - NULL
+        };
+
+        //Для kDelta каждые keyframe_steps шагов пишется полная строка, чтобы можно было восстановить состояние.
+        //deadband - отклонение double от последнего записанного в таблицу значения, которое не считается изменением.
+        //Вызывается до PreparingServerCalculation.
+        void SetOutputRecording(OutputRecording recording, size_t keyframe_steps = 600, double deadband = 0.0);
+
+        //Строки выходных таблиц копятся max_steps шагов или flush_interval и пишутся одним INSERT на таблицу.
+        //По умолчанию каждый шаг пишется сразу.
+        void SetOutputBatch(size_t max_steps, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(0));
+        //false - часть строк не поставлена в очередь БД, в том числе фоновым писателем после прошлой проверки
+        [[nodiscard]] bool FlushOutputSignals();
+
+        //Форматирование и постановка в очередь БД в фоновом потоке. Шаг только копирует значения выходных сигналов.
+        //capacity - число снимков в очереди, backpressure - что делать, если писатель не успевает.
+        void SetOutputPipeline(bool asynchronous, size_t capacity = 4, Backpressure backpressure = Backpressure::kBlock);
+        PipelineCounters GetOutputPipelineCounters() const;
+
+        //Столбец версии строки в таблицах коэффициентов (bigint, увеличиваемый триггером, или updated_at timestamptz).
+        //Если задан, UpdateCoefficients запрашивает только строки с версией больше последней прочитанной.
+        //Вызывается до PreparingServerCalculation.
+        void SetCoefficientVersionColumn(std::string name_column);
+
+        //Фоновое обновление коэффициентов раз в period. Поток сам выбирает и разбирает таблицы,
+        //а готовый снимок изменившихся коэффициентов применяется в начале следующего шага.
+        //В этом режиме UpdateCoefficients только применяет готовый снимок. period == 0 - выключить.
+        void SetCoefficientRefresh(std::chrono::milliseconds period);
+
+        //Гистограммы времени шага, чтения входов, каждого блока (метки type и block), форматирования вывода,
+        //постановки INSERT в очередь и обновления коэффициентов. Если path не пустой, каждые interval
+        //они записываются в файл в текстовом формате Prometheus. Вызывается до начала расчёта.
+        void SetMetrics(bool enabled, std::filesystem::path path = {}, std::chrono::milliseconds interval = std::chrono::milliseconds(10000));
+        const MetricsRegistry& GetMetrics() const{
+            return metrics_;
+        }
+        void ResetMetrics(){
+            metrics_.Reset();
+        }
 
         [[nodiscard]] bool UpdateCoefficients(bool need_wait_update = true);
         void CheckUpdateValue(bool waiting_all = false);
@@ -53,24 +301,38 @@ namespace calc_server{
             return name_inp_file_json_;
         }
 
-        void SetTimestemp(std::chrono::seconds timestemp){
+        //Время задаётся шагами: за шаг timestemp увеличивается на step_calc секунд
+        void SetTimestemp(std::chrono::microseconds timestemp){
             timestemp_ = timestemp;
             not_real_time_ = true;
         } 
 
+        enum class TimestempResolution{
+            kSeconds,
+            kMilliseconds,
+            kMicroseconds
+        };
+
+        //Точность timestemp в выходных таблицах. Дробная часть пишется как доли секунды ("1700000000.250"),
+        //для kTyped - через to_timestamp. Для шагов чаще 1 Гц нужна kMilliseconds или kMicroseconds.
+        //Вызывается до PreparingServerCalculation.
+        void SetTimestempResolution(TimestempResolution resolution){
+            timestemp_resolution_ = resolution;
+        }
+
         #ifdef DEBUG
             //Всё что находится в этой секции для отладки и в РЕЛИЗНОЙ ВЕРСИИ НЕ БУДЕТ! 
             //Если что-то из этого используется, то на свой страх и риск с последующим отключением этого функционала.
             const MapNameTableToValueOutputSignals& GetOutputSignals() const{
-                return signals_output_;
+                return maps_.signals_output;
             }
 
             MapNameInputSignalToData& GetInputSignals(){
-                return signals_input_;
+                return maps_.signals_input;
             }
 
             MapNameTableToValueCoefficients& GetCoefficients(){
-                return coefficients_;
+                return maps_.coefficients;
             }
                    
         #endif
@@ -78,40 +340,212 @@ namespace calc_server{
 
     private:
 
-        DatabaseManagements db_manager_;
+        //Поток журнала останавливается после потоков остальных членов, до выгрузки библиотеки
+        async_logger::LoggerSession logger_session_{logger};
+
+        std::unique_ptr<IDatabaseClient> db_client_ = std::make_unique<DatabaseManagementsClient>();
+        RequestTracker request_tracker_{*db_client_};
+
+        SignalStore<SignalInput> store_signals_input_;
+        SignalStore<Coefficient> store_coefficients_;
+        SignalStore<SignalOutput> store_signals_output_;
+
+        //Карты поиска объектов набора блоков
+        struct SignalMaps{
+            MapKKSToSetPtr update_value;
+
+            MapNameInputSignalToData signals_input;
+            MapNameTableToValueCoefficients coefficients;
+            MapNameTableToValueOutputSignals signals_output;
+
+            //Код -> объекты во всех таблицах, заполняется в CreateSignalOutput и CreateCoefficients.
+            //Один код в нескольких таблицах - неоднозначность, поиск без имени таблицы для него не выполняется.
+            std::unordered_map<std::string, std::vector<const SignalOutput*>> code_to_signals_output;
+            std::unordered_map<std::string, std::vector<const Coefficient*>> code_to_coefficients;
 
-        MapKKSToSetPtr update_value_;
-        MapNameInputSignalToData signals_input_;
-        MapNameTableToValueCoefficients coefficients_;
-        MapNameTableToValueOutputSignals signals_output_;
+            //Строки, заданные для коэффициента в моделях. data_row меняет шаг, поэтому при перезагрузке
+            //состав строк сравнивается с этой копией.
+            std::unordered_map<const Coefficient*, std::set<std::string>> coefficient_rows;
+
+            //Тип выходного сигнала из поля "type" модели (те же значения, что у входных сигналов).
+            //По нему выбирается тип столбца в OutputSchema::kTyped: значение сигнала до первого Process не определено.
+            std::unordered_map<const SignalOutput*, SignalInput::TypeSignals> type_signals_output;
+        };
+
+        SignalMaps maps_;
+
+        //Куда регистрируются сигналы создаваемых блоков. При перезагрузке объект с тем же кодом берётся из previous,
+        //если его описание не изменилось, иначе создаётся новый. Объекты previous в фоне только читаются.
+        struct Registration{
+            SignalMaps& maps;
+            const SignalMaps* previous = nullptr;
+        };
 
         std::unordered_map<std::string, DynamicLibrary> upload_library_;
+        std::unordered_map<std::string, CreateFunction> builtin_block_types_;
         std::vector<std::unique_ptr<ICalcElement>> created_blocks_;
+        std::vector<BlockWiring> blocks_wiring_;
+
+        size_t count_threads_ = 1;
+        size_t count_load_threads_ = 1;
+
+        //Блок, сигналы которого уже зарегистрированы, а Create ещё не вызван
+        struct PendingBlock{
+            static constexpr size_t kNewBlock = std::numeric_limits<size_t>::max();
+
+            CreateFunction create_block = nullptr;
+            MapNameInputSignalToDataPtr signals_input;
+            MapNameTableToValueCoefficientsPtr coefficients;
+            MapNameTableToValueOutputSignalsPtr signals_output;
+            BlockWiring wiring;
 
-        const SignalInput* CreateSignalInput(const json& data_signal);
-        MapNameInputSignalToDataPtr LoadSignalInput(const json& input_data);
+            //Номер в created_blocks_ блока, который переносится при перезагрузке вместо Create
+            size_t index_reused = kNewBlock;
+        };
+
+        static void RunLoadTasks(WorkStealingPool* pool, size_t count, const std::function<void(size_t)>& task);
+        static std::vector<std::vector<uint64_t>> ComputeBlockKeys(const std::vector<fs_path>& files_models, const std::vector<json>& load_jsons, WorkStealingPool* pool);
+
+        //Возвращают число ошибок, блоки с ошибками пропускаются
+        size_t RegisterModelBlocks( const std::vector<fs_path>& files_models,
+                                    const std::vector<json>& load_jsons,
+                                    const std::vector<std::vector<uint64_t>>& keys_blocks,
+                                    Registration& registration,
+                                    std::unordered_map<uint64_t, std::vector<size_t>>* reusable_blocks,
+                                    std::unordered_map<std::string, DynamicLibrary>* staged_libraries,
+                                    std::vector<PendingBlock>& pending_blocks
+        );
+        size_t CreatePendingBlocks( std::vector<PendingBlock>& pending_blocks,
+                                    WorkStealingPool* pool,
+                                    std::vector<std::unique_ptr<ICalcElement>>& blocks,
+                                    std::vector<BlockWiring>& blocks_wiring,
+                                    std::vector<size_t>* index_reused = nullptr
+        );
+
+        std::vector<fs_path> model_directories_;
+        std::unordered_map<std::string, uint64_t> library_stamps_;
+
+        //Набор блоков, подготовленный фоновым потоком перезагрузки
+        struct PreparedReload{
+            std::unordered_map<std::string, DynamicLibrary> libraries;     //Новые и изменённые плагины
+            std::unordered_map<std::string, uint64_t> library_stamps;
+            fs_path shadow_directory;                                       //Копии изменённых плагинов, из них загружены libraries
+            SignalMaps maps;
+            std::vector<std::unique_ptr<ICalcElement>> blocks;              //nullptr - блок переносится из created_blocks_
+            std::vector<BlockWiring> blocks_wiring;
+            std::vector<size_t> index_reused;
+            std::set<std::string> coefficient_tables;                       //Таблицы с новыми коэффициентами
+            std::unordered_map<std::string, std::set<std::string>> exist_tables;    //Списки таблиц БД, прочитанные в фоне
+            size_t count_created = 0;
+        };
+
+        //reload_thread_ и prepared_reload_ меняют RequestReload, ApplyPendingReload и StopReload из разных потоков
+        std::mutex mutex_reload_;
+        std::thread reload_thread_;
+        std::atomic<ReloadState> reload_state_{ReloadState::kIdle};
+        std::unique_ptr<PreparedReload> prepared_reload_;
+
+        bool PrepareReload(PreparedReload& prepared);
+        bool StageLibraries(PreparedReload& prepared);
+        bool PrepareReloadTables(PreparedReload& prepared);
+        void ApplyPendingReload();
+        void StopReload();
+
+        //Освобождает объекты хранилищ, на которые не ссылаются карты maps_ (старый набор после подстановки,
+        //объекты неудачной перезагрузки). Вызывается, когда поток перезагрузки не работает
+        size_t ReleaseUnusedSignals();
+
+        fs_path path_model_snapshot_;
+        json model_snapshot_;               //Прочитанный снимок
+        json model_snapshot_update_;        //Снимок текущей загрузки
+        size_t count_model_loads_ = 0;
+        size_t count_model_loads_from_snapshot_ = 0;
+        bool model_snapshot_complete_ = true;
+        std::vector<fs_path> dll_directories_;
+
+        //Каталоги копий плагинов, загруженных при перезагрузке, удаляются после выгрузки плагинов
+        std::vector<fs_path> shadow_directories_;
+        void RemoveShadowDirectories();
+
+        bool TakeModelsFromSnapshot(uint64_t key_models, std::vector<json>& load_jsons);
+        uint64_t ComputeEnvironmentKey() const;
+        bool RestoreTablesFromSnapshot();
+        //Таблицы и столбцы, нужные моделям, есть в базе: снимок мог устареть после изменений в базе
+        bool CheckSnapshotTables();
+        void SaveModelSnapshot();
+
+        static std::vector<fs_path> ListModelFiles(const fs_path& path);
+        static json ParseModelFile(const fs_path& path);
+        std::unique_ptr<WorkStealingPool> block_pool_;
+        BlockGraph block_graph_;
+
+        bool incremental_mode_ = false;
+        bool need_process_all_ = true;
+        std::set<std::string> always_process_types_;
+        std::unordered_map<const void*, std::vector<int>> object_to_blocks_;
+        std::vector<const Coefficient*> changed_coefficients_;
+        std::vector<char> active_blocks_;
+
+        void BuildBlockGraph();
+        void MarkActiveBlocks();
+        void ProcessBlocks(double current_time, double step_calc);
+        [[nodiscard]] bool ComputeStep(double current_time, double step_calc);
+        [[nodiscard]] bool CalcStepAt(std::chrono::system_clock::time_point start_step, double current_time, double step_calc);
+
+        StepScheduler step_scheduler_;
+        std::chrono::system_clock::time_point step_start_time_;
+        void ProcessBlock(size_t block, double current_time, double step_calc);
+
+        MetricsRegistry metrics_;
+        bool metrics_enabled_ = false;
+        LatencyHistogram* histogram_step_ = nullptr;
+        LatencyHistogram* histogram_ingest_ = nullptr;
+        LatencyHistogram* histogram_process_ = nullptr;
+        LatencyHistogram* histogram_serialization_ = nullptr;
+        LatencyHistogram* histogram_enqueue_ = nullptr;
+        LatencyHistogram* histogram_coefficient_reload_ = nullptr;
+        LatencyHistogram* histogram_start_jitter_ = nullptr;
+        std::vector<LatencyHistogram*> histogram_blocks_;
+        void RegisterBlockMetrics();
+
+        const SignalInput* CreateSignalInput(const json& data_signal, Registration& registration);
+        MapNameInputSignalToDataPtr LoadSignalInput(const json& input_data, Registration& registration);
         const SignalInput* GetSignalInput(const std::string& code) const;
 
-        SignalOutput* CreateSignalOutput(const json& data_signal);
-        MapNameTableToValueOutputSignalsPtr LoadSignalOutput(const json& output_data);
+        SignalOutput* CreateSignalOutput(const json& data_signal, Registration& registration);
+        MapNameTableToValueOutputSignalsPtr LoadSignalOutput(const json& output_data, Registration& registration);
         const SignalOutput* GetSignalOutput(const std::string& code, const std::string& table_name = "") const;
 
-        MapNameTableToValueCoefficientsPtr CreateCoefficients(const json& data_signal);
-        MapNameTableToValueCoefficientsPtr LoadSignalCoefficient(const json& coef_data);
+        MapNameTableToValueCoefficientsPtr CreateCoefficients(const json& data_signal, Registration& registration);
+        MapNameTableToValueCoefficientsPtr LoadSignalCoefficient(const json& coef_data, Registration& registration);
         const Coefficient* GetCoefficient(const std::string& code, const std::string& table_name = "") const;
 
         template<typename TypeData>
-        const TypeData* SearchInTable(const std::unordered_map<std::string, TypeData>& map_data, const std::string& code) const;
+        const TypeData* FindByCode( const std::unordered_map<std::string, std::vector<const TypeData*>>& code_to_data,
+                                    const std::unordered_map<std::string, std::unordered_map<std::string, TypeData*>>& tables,
+                                    const std::string& code,
+                                    const std::string& table_name
+        ) const;
 
-        using CreateFunction = std::unique_ptr<ICalcElement> (*)(MapNameInputSignalToDataPtr&& inp,
-                                                        MapNameTableToValueCoefficientsPtr&& coef,
-                                                        MapNameTableToValueOutputSignalsPtr&& output
-        );
 
         [[nodiscard]] bool UpdateValueInputSignals(const std::string& name_file_inp_ = "");
+        [[nodiscard]] bool ApplyValueInputSignals(std::string_view content, const std::string& name_file);
+        [[nodiscard]] bool UpdateValueInputSignalsFromSharedMemory();
+        void CheckMissingInputSignals();
+        void BuildInputSlots();
 
         std::string name_inp_file_json_ = "ValueInputSignals.json";
 
+        InputMode input_mode_ = InputMode::kFullReload;
+        InputFileWatcher input_file_watcher_;
+        //Буфер чтения файла в режиме kFullReload, ёмкость сохраняется между шагами
+        std::string input_file_content_;
+        SharedMemoryInput shared_memory_input_;
+        KKSSlotTable kks_slot_table_;
+        std::vector<int> slots_check_missing_;
+        //По одному на slots_check_missing_: отсутствие KKS уже сообщено, сбрасывается, когда KKS снова пришёл
+        std::vector<char> slots_reported_missing_;
+
         [[nodiscard]] bool ConnectDatabase(const std::string& name_connect);
 
         const std::string name_db_out_ = "output";
@@ -119,10 +553,22 @@ namespace calc_server{
 
         bool CheckTableExist(const std::string& name_table, const std::string& name_connection) const;
         bool UpdateListExistTable(const std::string& name_connection);
+
+        //Те же проверки для списка exist_tables, а не name_db_to_exist_tables_: перезагрузка
+        //заполняет свой список, текущий заменяется только при подстановке набора
+        static bool CheckTableExist(const std::string& name_table, const std::set<std::string>& exist_tables);
+        bool UpdateListExistTable(const std::string& name_connection, std::set<std::string>& exist_tables);
         
-        bool PreparingOutputTables();
+        //Создание таблиц и столбцов для сигналов tables, существующие столбцы не изменяются.
+        //exist_tables - список таблиц подключения name_db_out_, обновляется после изменения схемы
+        bool PreparingOutputTables(const MapNameTableToValueOutputSignals& tables, const SignalMaps& maps, std::set<std::string>& exist_tables);
+        //Столбцы таблиц tables (имена в нижнем регистре) одним запросом к information_schema.columns,
+        //в table_to_columns добавляются только найденные таблицы
+        bool SelectTableColumns(const std::string& name_connection, const std::set<std::string>& tables, std::unordered_map<std::string, std::set<std::string>>& table_to_columns);
         bool PreparingRecordRequestOut();
         bool PreparingRecordRequestCoef();
+        std::string GetCoefficientSelect(const std::string& table_name) const;
+        void AddCoefficientRequests(const std::string& table_name);
 
         std::unordered_map<std::string, std::set<std::string>> name_db_to_exist_tables_ = {
             {name_db_out_, {}}, {name_db_coefficient_, {}}
@@ -131,28 +577,144 @@ namespace calc_server{
         std::unordered_map<std::string, std::string> name_table_to_request_insert_;
         std::unordered_map<std::string, std::string> name_table_to_request_select_;
 
+        std::string coefficient_version_column_;
+        //Запросы только изменившихся строк и последняя прочитанная версия таблицы
+        std::unordered_map<std::string, std::string> name_table_to_request_select_changed_;
+        std::unordered_map<std::string, std::string> name_table_to_coefficient_version_;
+
+        using CoefficientRow = decltype(Coefficient::data_row);
+
+        struct CoefficientUpdate{
+            Coefficient* target;
+            CoefficientRow data_row;
+        };
+
+        //Изменившиеся коэффициенты одного или нескольких обновлений, после публикации не изменяется
+        using CoefficientSnapshot = std::vector<CoefficientUpdate>;
+
+        //published - значения, известные потоку обновления; nullptr - сравнение с текущими значениями коэффициентов
+        void ParseCoefficientsFromSelect(   ResultInsertRequest& result_select,
+                                            std::unordered_map<const Coefficient*, CoefficientRow>* published,
+                                            CoefficientSnapshot& snapshot
+        );
+        //Строки выборки для коэффициентов table_content, version - версия таблицы из выборки
+        void ParseCoefficientRows(  ResultInsertRequest& result_select,
+                                    const MapNameCoefficientToValue& table_content,
+                                    std::unordered_map<const Coefficient*, CoefficientRow>* published,
+                                    CoefficientSnapshot& snapshot,
+                                    std::string& version
+        ) const;
+        void ApplyCoefficientSnapshot(CoefficientSnapshot& snapshot);
+        void ApplyPendingCoefficients();
+
+        //Отсутствующий столбец коэффициента сообщается один раз на пару (таблица, столбец), а не при каждом
+        //обновлении для каждого коэффициента. Вызывается из шага, потока обновления и потока перезагрузки
+        void ReportMissingCoefficientColumn(const std::string& table_name, const std::string& name_row, const std::string& name_signal) const;
+        mutable std::mutex mutex_missing_coefficient_columns_;
+        mutable std::unordered_set<std::string> missing_coefficient_columns_;
+
+        void StartCoefficientRefresher();
+        void StopCoefficientRefresher();
+        void CoefficientRefreshLoop();
+
+        std::chrono::milliseconds coefficient_refresh_period_{0};
+        bool coefficients_prepared_ = false;
+
+        //Снимок, опубликованный потоком обновления и ещё не применённый шагом
+        std::atomic<CoefficientSnapshot*> pending_coefficients_{nullptr};
+
+        std::thread coefficient_refresher_;
+        std::mutex mutex_coefficient_refresher_;
+        std::condition_variable cv_coefficient_refresher_;
+        bool stop_coefficient_refresher_ = false;
+
         bool WriteOutputSignalsToDatabase();
+
+        OutputBatcher output_batcher_;
+        OutputSchema output_schema_ = OutputSchema::kText;
+
+        //Столбцы выходной таблицы для сигнала: имя и тип
+        std::vector<std::pair<std::string, std::string>> GetOutputColumns(const SignalOutput& signal, const SignalMaps& maps) const;
+        std::string GetTimestempType() const;
+        std::string FormatTimestemp(std::chrono::microseconds timestemp) const;
+        std::chrono::microseconds GetTimestempUnit() const;
+
+        struct WrittenSignalOutput{
+            OutputValue output;
+            bool written = false;
+        };
+
+        struct OutputTableLayout{
+            std::string name;
+            int index_batcher = -1;
+            std::vector<const SignalOutput*> signals;
+        };
+
+        OutputRecording output_recording_ = OutputRecording::kFull;
+        size_t keyframe_steps_ = 600;
+        size_t steps_since_keyframe_ = 0;
+        double output_deadband_ = 0.0;
+
+        //Порядок таблиц и сигналов совпадает с порядком столбцов в запросе на запись
+        std::vector<OutputTableLayout> output_tables_;
+        std::vector<std::vector<WrittenSignalOutput>> last_written_output_;
+
+        OutputSnapshot output_snapshot_;
+        std::unique_ptr<OutputPipeline<OutputSnapshot>> output_pipeline_;
+        std::mutex mutex_output_writer_;
+
+        //Ошибки фонового писателя: всего и уже сообщённые вызывающему WriteOutputSignalsToDatabase или FlushOutputSignals
+        std::atomic<size_t> count_output_write_errors_{0};
+        std::atomic<size_t> count_output_write_errors_reported_{0};
+
+        //true - с прошлой проверки фоновый писатель не смог поставить в очередь БД хотя бы одну запись
+        bool TakeNewOutputWriteErrors();
+
+        void TakeOutputSnapshot(OutputSnapshot& snapshot) const;
+        bool WriteOutputSnapshot(const OutputSnapshot& snapshot);
+        bool FlushBatchOutputSignals();
+        bool IsChangedOutput(const WrittenSignalOutput& last, const OutputValue& current) const;
         
-        std::set<int> id_request_select_wait_;
+        //Ожидаемые выборки коэффициентов по имени таблицы
+        std::unordered_map<std::string, RequestHandle> select_coefficients_wait_;
 
         bool not_real_time_ = false;
 
-        std::chrono::seconds timestemp_ = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+        //Хранится в микросекундах, в таблицы пишется с точностью timestemp_resolution_
+        std::chrono::microseconds timestemp_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+        TimestempResolution timestemp_resolution_ = TimestempResolution::kSeconds;
 
     };
 
     template<typename TypeData>
-    const TypeData* CalcServer::SearchInTable(const std::unordered_map<std::string, TypeData>& map_data, const std::string& code) const{
+    const TypeData* CalcServer::FindByCode( const std::unordered_map<std::string, std::vector<const TypeData*>>& code_to_data,
+                                            const std::unordered_map<std::string, std::unordered_map<std::string, TypeData*>>& tables,
+                                            const std::string& code,
+                                            const std::string& table_name
+    ) const{
+
+        //Ключ во вложенной таблице - код объекта
+        if(table_name != ""){
+            auto table = tables.find(table_name);
+            if(table == tables.end()){
+                return nullptr;
+            }
+
+            auto data = table->second.find(code);
+            return (data == table->second.end()) ? nullptr : data->second;
+        }
 
-        auto rezult = std::find_if(map_data.begin(), map_data.end(),
-            [code](const auto& item){ return item.second.code == code; });
+        auto data = code_to_data.find(code);
+        if(data == code_to_data.end()){
+            return nullptr;
+        }
 
-        if(rezult == map_data.end()){
-            //using ValueType = typename std::unordered_map<std::string, TypeDataPtr>::mapped_type;
+        if(data->second.size() > 1){
+            logger.log("The code \"" + code + "\" exists in " + std::to_string(data->second.size()) + " tables, specify the table name", Logger::LogLevel::kWarning);
             return nullptr;
         }
 
-        return &rezult->second;
+        return data->second.front();
     }
 
     struct GetValueToStringSignalsVariantOut{
@@ -167,6 +729,35 @@ namespace calc_server{
         };
     };
 
+    inline std::string GetSQLTypeSignal(SignalInput::TypeSignals type){
+        switch(type){
+            case SignalInput::TypeSignals::kTS_int:
+                return "integer";
+            case SignalInput::TypeSignals::kTS_double:
+                return "double precision";
+            default:
+                return "character varying";
+        }
+    }
+
+    //Запись значения в строку без потоков и без лишних аллокаций, строка переиспользуется
+    struct WriteValueSignalsVariantOut{
+        std::string& target;
+
+        void operator()(int data_int) {WriteNumber(data_int);};
+        void operator()(double data_double) {WriteNumber(data_double);};
+        void operator()(const std::string& data_string) {target.assign(data_string);};
+        template<typename T>
+        void operator()(const T& value) {target = GetValueToStringSignalsVariantOut()(value);};
+
+        template<typename T>
+        void WriteNumber(T value){
+            char buffer[32];
+            auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            target.assign(buffer, end);
+        }
+    };
+
     #ifdef DEBUG
     //Всё что находится в этой секции для отладки и в РЕЛИЗНОЙ ВЕРСИИ НЕ БУДЕТ! 
     //Если что-то из этого используется, то на свой страх и риск с последующим отключением этого функционала.
@@ -194,7 +785,7 @@ namespace calc_server{
             auto& terget_table = server.GetCoefficients()[table_name];
 
             for(auto& [name_coef, value] : terget_table){
-                for(auto& [name_row, value] : value.data_row){
+                for(auto& [name_row, value] : value->data_row){
                     value = values.at(name_row);
                 }
             }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "calcelement.h"
+
+namespace calc_server_bench{
+
+    using namespace calc_element;
+
+    //Простейший блок для замеров: сумма входов, умноженная на коэффициент "k", записывается во все выходы
+    class SumBlock : public ICalcElement{
+    public:
+        SumBlock(   MapNameInputSignalToDataPtr&& inputs,
+                    MapNameTableToValueCoefficientsPtr&& coefficients,
+                    MapNameTableToValueOutputSignalsPtr&& outputs
+        ){
+            for(const auto& [code, signal] : inputs){
+                inputs_.push_back(signal);
+            }
+
+            for(const auto& [table, content] : coefficients){
+                for(const auto& [code, coefficient] : content){
+                    coefficients_.push_back(coefficient);
+                }
+            }
+
+            for(const auto& [table, content] : outputs){
+                for(const auto& [code, signal] : content){
+                    outputs_.push_back(signal);
+                }
+            }
+        }
+
+        void Process(double current_time, double step_calc) override{
+            double sum = 0.0;
+
+            for(const SignalInput* signal : inputs_){
+                if(const double* value = std::get_if<double>(&signal->value); value != nullptr){
+                    sum += *value;
+                }else if(const int* value_int = std::get_if<int>(&signal->value); value_int != nullptr){
+                    sum += *value_int;
+                }
+            }
+
+            double factor = 1.0;
+            for(const Coefficient* coefficient : coefficients_){
+                if(auto k = coefficient->data_row.find("k"); k != coefficient->data_row.end()){
+                    if(const double* value = std::get_if<double>(&k->second); value != nullptr){
+                        factor *= *value;
+                    }
+                }
+            }
+
+            for(size_t i = 0; i < outputs_.size(); ++i){
+                outputs_[i]->value = sum * factor + static_cast<double>(i);
+            }
+        }
+
+        void GenerateDebugData(nlohmann::json& data, double current_time, double step_calc) override{}
+
+    private:
+        std::vector<const SignalInput*> inputs_;
+        std::vector<const Coefficient*> coefficients_;
+        std::vector<SignalOutput*> outputs_;
+    };
+
+    inline std::unique_ptr<ICalcElement> CreateSumBlock(MapNameInputSignalToDataPtr&& inputs,
+                                                        MapNameTableToValueCoefficientsPtr&& coefficients,
+                                                        MapNameTableToValueOutputSignalsPtr&& outputs
+    ){
+        return std::make_unique<SumBlock>(std::move(inputs), std::move(coefficients), std::move(outputs));
+    }
+
+}//namespace calc_server_bench
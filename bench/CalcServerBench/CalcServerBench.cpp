@@ -0,0 +1,373 @@
+//Замер производительности CalcServer без PostgreSQL и DLL: синтетические модели,
+//встроенный тип блока и база данных в памяти процесса.
+//Пример: CalcServerBench --blocks=20000 --inputs-per-block=8 --steps=500 --threads=4 --incremental
+//--replay: шаги читаются из заранее записанного файла JSON Lines через CalcServer::RunReplay
+//--calc-steps: все шаги одним вызовом CalcServer::CalcSteps, значения задаются в памяти без файла
+//--snapshot: модели и списки таблиц читаются из снимка, если он есть и модели не изменились.
+//           Схема выходных таблиц базы в памяти сохраняется между запусками в output.schema
+//--period-ms=N: шаги по расписанию CalcServer::StartRealTime с периодом N мс, входной файл не меняется
+//--reload-at=N: перед шагом N у части блоков меняется модель и вызывается CalcServer::RequestReload
+//--busy-queue: очередь базы данных никогда не пустеет, как при непрерывной записи выходных сигналов
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "CalcServer.h"
+#include "BenchBlocks.h"
+#include "FakeDatabase.h"
+#include "ModelGenerator.h"
+
+namespace{
+
+    std::atomic<size_t> count_allocations{0};
+
+}
+
+void* operator new(std::size_t size){
+    count_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if(void* pointer = std::malloc((size == 0) ? 1 : size)){
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept{
+    std::free(pointer);
+}
+
+namespace{
+
+    using namespace calc_server_bench;
+
+    struct BenchSettings{
+        ModelSettings model;
+        size_t steps = 200;
+        size_t warmup_steps = 10;
+        double changed_fraction = 0.1;
+        size_t count_threads = 1;
+        bool incremental = false;
+        bool watch_input = false;
+        bool typed_output = false;
+        bool delta_output = false;
+        bool async_output = false;
+        bool replay = false;
+        bool calc_steps = false;
+        bool model_snapshot = false;
+        bool busy_queue = false;
+        size_t batch_steps = 0;
+        size_t period_ms = 0;
+        size_t load_threads = 1;
+        size_t reload_at = 0;
+        std::string directory = "calc_server_bench_data";
+    };
+
+    bool ParseArguments(int argc, char* argv[], BenchSettings& settings){
+        std::unordered_map<std::string, size_t*> sizes = {
+            {"--blocks", &settings.model.count_blocks},
+            {"--inputs-per-block", &settings.model.inputs_per_block},
+            {"--outputs-per-block", &settings.model.outputs_per_block},
+            {"--inputs", &settings.model.count_inputs},
+            {"--output-tables", &settings.model.count_output_tables},
+            {"--coef-tables", &settings.model.count_coefficient_tables},
+            {"--coefs-per-table", &settings.model.coefficients_per_table},
+            {"--steps", &settings.steps},
+            {"--warmup", &settings.warmup_steps},
+            {"--threads", &settings.count_threads},
+            {"--batch", &settings.batch_steps},
+            {"--period-ms", &settings.period_ms},
+            {"--load-threads", &settings.load_threads},
+            {"--reload-at", &settings.reload_at}
+        };
+
+        std::unordered_map<std::string, bool*> flags = {
+            {"--incremental", &settings.incremental},
+            {"--watch-input", &settings.watch_input},
+            {"--typed", &settings.typed_output},
+            {"--delta", &settings.delta_output},
+            {"--async-output", &settings.async_output},
+            {"--replay", &settings.replay},
+            {"--calc-steps", &settings.calc_steps},
+            {"--snapshot", &settings.model_snapshot},
+            {"--busy-queue", &settings.busy_queue}
+        };
+
+        for(int i = 1; i < argc; ++i){
+            std::string argument = argv[i];
+            std::string name = argument.substr(0, argument.find('='));
+            std::string value = (argument.find('=') == std::string::npos) ? "" : argument.substr(argument.find('=') + 1);
+
+            if(auto size = sizes.find(name); size != sizes.end() && !value.empty()){
+                *size->second = std::stoull(value);
+            }else if(auto flag = flags.find(name); flag != flags.end()){
+                *flag->second = true;
+            }else if(name == "--changed" && !value.empty()){
+                settings.changed_fraction = std::stod(value);
+            }else if(name == "--dir" && !value.empty()){
+                settings.directory = value;
+            }else{
+                std::cerr << "Unknown argument: " << argument << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    double GetMeanMicroseconds(const calc_server::MetricsRegistry& metrics, const std::string& name){
+        const auto* histogram = metrics.FindHistogram(name);
+        if(histogram == nullptr || histogram->GetCount() == 0){
+            return 0.0;
+        }
+
+        return histogram->GetSum() * 1e6 / static_cast<double>(histogram->GetCount());
+    }
+
+}
+
+int main(int argc, char* argv[]){
+    BenchSettings settings;
+
+    if(!ParseArguments(argc, argv, settings)){
+        return 1;
+    }
+
+    std::filesystem::path directory = settings.directory;
+    std::filesystem::path path_models = directory / "models";
+    std::filesystem::path path_input = directory / "ValueInputSignals.json";
+
+    GeneratedModel model = GenerateModel(settings.model, "BenchSum", path_models);
+
+    auto database = std::make_unique<FakeDatabase>();
+    database->SetTables("coefficient", model.coefficient_tables);
+
+    //Снимок проверяется по столбцам выходных таблиц, поэтому их схема хранится рядом со снимком
+    std::filesystem::path path_output_schema = directory / "output.schema";
+    if(settings.model_snapshot){
+        database->LoadSchema("output", path_output_schema);
+    }
+
+    database->SetAlwaysBusy(settings.busy_queue);
+    FakeDatabase* fake_database = database.get();
+
+    calc_server::CalcServer server(std::move(database));
+
+    //Деструктор сервера ждёт, пока очередь БД опустеет
+    struct ReleaseQueue{
+        FakeDatabase* database;
+        ~ReleaseQueue(){
+            database->SetAlwaysBusy(false);
+        }
+    } release_queue{fake_database};
+
+    server.RegisterBlockType("BenchSum", CreateSumBlock);
+    server.SetCountThreads(settings.count_threads);
+    server.SetCountLoadThreads(settings.load_threads);
+
+    if(settings.model_snapshot){
+        server.SetModelSnapshot(directory / "models.snapshot");
+    }
+    server.SetIncrementalMode(settings.incremental);
+    server.SetInputMode((settings.watch_input) ? calc_server::CalcServer::InputMode::kWatchChanges : calc_server::CalcServer::InputMode::kFullReload);
+    server.SetOutputFile(path_input.string());
+    server.SetOutputSchema((settings.typed_output) ? calc_server::CalcServer::OutputSchema::kTyped : calc_server::CalcServer::OutputSchema::kText);
+
+    if(settings.delta_output){
+        server.SetOutputRecording(calc_server::CalcServer::OutputRecording::kDelta);
+    }
+
+    if(settings.batch_steps > 1){
+        server.SetOutputBatch(settings.batch_steps);
+    }
+
+    server.SetOutputPipeline(settings.async_output);
+    server.SetTimestemp(std::chrono::seconds(0));
+    server.SetMetrics(true);
+
+    auto start_load = std::chrono::steady_clock::now();
+
+    server.CreateBlocksFromJSON(path_models);
+
+    if(!server.PreparingServerCalculation()){
+        std::cerr << "PreparingServerCalculation failed\n";
+        return 1;
+    }
+
+    auto time_load = std::chrono::steady_clock::now() - start_load;
+
+    if(settings.model_snapshot){
+        fake_database->SaveSchema("output", path_output_schema);
+    }
+
+    std::mt19937 random(settings.model.seed);
+    std::chrono::nanoseconds time_steps{0};
+    size_t allocations_steps = 0;
+
+    if(settings.replay){
+        //Весь поток читается одним вызовом, прогрев не выделяется
+        std::filesystem::path path_replay = directory / "ValueInputSignals.jsonl";
+        WriteReplayFile(model, path_replay, settings.steps, settings.changed_fraction, random);
+
+        size_t allocations_before = count_allocations.load(std::memory_order_relaxed);
+        auto start_replay = std::chrono::steady_clock::now();
+
+        auto result = server.RunReplay(path_replay);
+        if(!result.completed){
+            std::cerr << "RunReplay failed after step " << result.steps << "\n";
+            return 1;
+        }
+
+        time_steps = std::chrono::steady_clock::now() - start_replay;
+        allocations_steps = count_allocations.load(std::memory_order_relaxed) - allocations_before;
+    }
+
+    if(settings.calc_steps){
+        std::vector<int> slots;
+        calc_server::CalcServer::InputProvider provider = [&](size_t index_step, double, calc_server::CalcServer::StepInput& input){
+            if(slots.empty()){
+                for(const auto& kks : model.kks_inputs){
+                    slots.push_back(input.FindSlot(kks));
+                }
+            }
+
+            std::bernoulli_distribution changed(settings.changed_fraction);
+            for(size_t index_input = 0; index_input < slots.size(); ++index_input){
+                if(slots[index_input] != input_signals::KKSSlotTable::kNotFound && (index_step == 0 || changed(random))){
+                    input.SetValue(slots[index_input], static_cast<double>(index_step) + static_cast<double>(index_input) * 0.001);
+                }
+            }
+            return true;
+        };
+
+        size_t allocations_before = count_allocations.load(std::memory_order_relaxed);
+        auto start_steps = std::chrono::steady_clock::now();
+
+        auto result = server.CalcSteps(0, 1, settings.steps, provider);
+        if(result.steps.size() != settings.steps || result.steps.back() != calc_server::CalcServer::StepStatus::kOk){
+            std::cerr << "CalcSteps failed after step " << result.steps.size() << "\n";
+            return 1;
+        }
+
+        time_steps = std::chrono::steady_clock::now() - start_steps;
+        allocations_steps = count_allocations.load(std::memory_order_relaxed) - allocations_before;
+    }
+
+    if(settings.period_ms > 0){
+        WriteInputFile(model, path_input, 0, settings.changed_fraction, random);
+
+        calc_server::StepScheduler::Settings real_time;
+        real_time.period = std::chrono::milliseconds(settings.period_ms);
+
+        if(!server.StartRealTime(real_time)){
+            return 1;
+        }
+
+        std::this_thread::sleep_for(real_time.period * settings.steps);
+        server.StopRealTime();
+
+        auto counters = server.GetRealTimeCounters();
+        std::cout << "scheduled steps:        " << counters.steps << "\n"
+                  << "overruns:               " << counters.overruns << "\n"
+                  << "skipped:                " << counters.skipped << "\n"
+                  << "max start jitter, us:   " << std::chrono::duration<double, std::micro>(counters.max_jitter).count() << "\n"
+                  << "start jitter p99, us:   " << server.GetMetrics().FindHistogram("calc_server_step_start_jitter_seconds")->GetQuantile(0.99) * 1e6 << "\n";
+        return 0;
+    }
+
+    bool reload_requested = false;
+    size_t reload_swap_step = 0;
+    std::chrono::nanoseconds reload_swap_time{0};
+
+    for(size_t step = 0; !settings.replay && !settings.calc_steps && step < settings.warmup_steps + settings.steps; ++step){
+        if(step == settings.warmup_steps){
+            server.ResetMetrics();
+        }
+
+        if(settings.reload_at != 0 && step == settings.reload_at){
+            ChangeModel(path_models, 10);
+
+            if(!server.RequestReload()){
+                std::cerr << "RequestReload failed\n";
+                return 1;
+            }
+            reload_requested = true;
+        }
+
+        bool reload_pending = reload_requested && reload_swap_step == 0;
+
+        WriteInputFile(model, path_input, step, settings.changed_fraction, random);
+
+        size_t allocations_before = count_allocations.load(std::memory_order_relaxed);
+        auto start_step = std::chrono::steady_clock::now();
+
+        if(!server.CalcOneStep(static_cast<double>(step))){
+            std::cerr << "CalcOneStep failed at step " << step << "\n";
+            return 1;
+        }
+
+        if(step >= settings.warmup_steps){
+            time_steps += std::chrono::steady_clock::now() - start_step;
+            allocations_steps += count_allocations.load(std::memory_order_relaxed) - allocations_before;
+        }
+
+        if(reload_pending){
+            auto state = server.GetReloadState();
+            if(state == calc_server::CalcServer::ReloadState::kFailed){
+                std::cerr << "Reload of models failed\n";
+                return 1;
+            }
+
+            //Подстановка выполняется в начале шага, её время входит в длительность этого шага
+            if(state == calc_server::CalcServer::ReloadState::kIdle){
+                reload_swap_step = step;
+                reload_swap_time = std::chrono::steady_clock::now() - start_step;
+            }
+        }
+    }
+
+    if(!server.FlushOutputSignals()){
+        std::cerr << "FlushOutputSignals failed\n";
+    }
+
+    const auto& metrics = server.GetMetrics();
+    const auto* histogram_step = metrics.FindHistogram("calc_server_step_seconds");
+    auto counters = fake_database->GetCounters();
+    double seconds = std::chrono::duration<double>(time_steps).count();
+    double steps = static_cast<double>(std::max<size_t>(settings.steps, 1));
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "blocks:                 " << settings.model.count_blocks << "\n"
+              << "load and prepare, ms:   " << std::chrono::duration<double, std::milli>(time_load).count() << "\n"
+              << "steps/second:           " << ((seconds > 0) ? steps / seconds : 0.0) << "\n"
+              << "step mean, us:          " << GetMeanMicroseconds(metrics, "calc_server_step_seconds") << "\n"
+              << "step p99, us:           " << ((histogram_step != nullptr) ? histogram_step->GetQuantile(0.99) * 1e6 : 0.0) << "\n"
+              << "  ingest mean, us:      " << GetMeanMicroseconds(metrics, "calc_server_ingest_seconds") << "\n"
+              << "  process mean, us:     " << GetMeanMicroseconds(metrics, "calc_server_process_seconds") << "\n"
+              << "  serialize mean, us:   " << GetMeanMicroseconds(metrics, "calc_server_output_serialization_seconds") << "\n"
+              << "  enqueue mean, us:     " << GetMeanMicroseconds(metrics, "calc_server_output_enqueue_seconds") << "\n"
+              << "allocations/step:       " << static_cast<double>(allocations_steps) / steps << "\n"
+              << "insert requests:        " << counters.inserts << "\n"
+              << "insert parameters:      " << counters.parameters << "\n"
+              << "insert bytes:           " << counters.bytes << "\n";
+
+    if(reload_requested && reload_swap_step == 0){
+        std::cout << "reload swapped at step: not applied before the last step\n";
+    }else if(reload_requested){
+        std::cout << "reload swapped at step: " << reload_swap_step << "\n"
+                  << "reload swap step, ms:   " << std::chrono::duration<double, std::milli>(reload_swap_time).count() << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "FakeDatabase.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <regex>
+#include <string_view>
+
+namespace calc_server_bench{
+
+    void FakeDatabase::SetTables(const std::string& name_connection, TablesData tables){
+        std::lock_guard lock(mutex_);
+        connection_to_tables_[name_connection] = std::move(tables);
+    }
+
+    bool FakeDatabase::LoadSchema(const std::string& name_connection, const std::filesystem::path& path){
+        std::ifstream file(path);
+        if(!file.is_open()){
+            return false;
+        }
+
+        std::lock_guard lock(mutex_);
+        auto& tables = connection_to_tables_[name_connection];
+        auto& columns = connection_to_columns_[name_connection];
+
+        std::string table;
+        std::string column;
+        while(file >> table >> column){
+            tables[table];
+            columns[table].insert(column);
+        }
+
+        return true;
+    }
+
+    bool FakeDatabase::SaveSchema(const std::string& name_connection, const std::filesystem::path& path) const{
+        std::ofstream file(path, std::ios::trunc);
+        if(!file.is_open()){
+            return false;
+        }
+
+        std::lock_guard lock(mutex_);
+        auto columns = connection_to_columns_.find(name_connection);
+        if(columns != connection_to_columns_.end()){
+            for(const auto& [table, names] : columns->second){
+                for(const auto& column : names){
+                    file << table << ' ' << column << '\n';
+                }
+            }
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    bool FakeDatabase::CreateConnectionDatabase(const ConnectionInfo& connection_info){
+        std::lock_guard lock(mutex_);
+        connection_to_tables_[connection_info.id_connection];
+        return true;
+    }
+
+    IDatabaseClient::QueueResult FakeDatabase::InsertRequestInQueue(const std::string& name_connection,
+                                                                    const std::string& query,
+                                                                    std::vector<std::string> values,
+                                                                    Command command,
+                                                                    const std::string& name_table
+    ){
+        std::lock_guard lock(mutex_);
+
+        int id_request = next_id_++;
+
+        if(command == Command::kSelect){
+            ++counters_.selects;
+            id_to_result_[id_request] = Select(name_connection, query, name_table);
+            id_to_result_[id_request].id_request = id_request;
+
+            return {ResultRequest::kInProcessing, id_request};
+        }
+
+        if(query.starts_with("DO ") || query.starts_with("CREATE ") || query.starts_with("ALTER ")){
+            ExecuteSchema(name_connection, query);
+            return {ResultRequest::kInProcessing, id_request};
+        }
+
+        ++counters_.inserts;
+        counters_.parameters += values.size();
+        for(const auto& value : values){
+            counters_.bytes += value.size();
+        }
+
+        return {ResultRequest::kInProcessing, id_request};
+    }
+
+    ResultInsertRequest FakeDatabase::GetResultSelectFromID(int id_request){
+        std::lock_guard lock(mutex_);
+
+        auto result = id_to_result_.find(id_request);
+        if(result == id_to_result_.end()){
+            return {};
+        }
+
+        ResultInsertRequest answer = std::move(result->second);
+        id_to_result_.erase(result);
+
+        return answer;
+    }
+
+    FakeDatabase::Counters FakeDatabase::GetCounters() const{
+        std::lock_guard lock(mutex_);
+        return counters_;
+    }
+
+    ResultInsertRequest FakeDatabase::Select(const std::string& name_connection, const std::string& query, const std::string& name_table){
+        ResultInsertRequest result;
+        result.name_table = name_table;
+
+        auto& tables = connection_to_tables_[name_connection];
+
+        if(query.find("information_schema.tables") != std::string::npos){
+            for(const auto& [table, rows] : tables){
+                result.code_to_map_field_value[table]["table_name"] = table;
+            }
+            return result;
+        }
+
+        //Для таблиц, заданных через SetTables, столбцы не известны: отвечают только id и timestemp
+        if(query.find("information_schema.columns") != std::string::npos){
+            auto& columns = connection_to_columns_[name_connection];
+            static const std::set<std::string> default_columns = {"id", "timestemp"};
+
+            for(const auto& [table, rows] : tables){
+                auto table_columns = columns.find(table);
+
+                for(const auto& column : (table_columns != columns.end()) ? table_columns->second : default_columns){
+                    auto& fields = result.code_to_map_field_value[table + "." + column];
+                    fields["table_name"] = table;
+                    fields["column_name"] = column;
+                }
+            }
+            return result;
+        }
+
+        std::smatch match;
+        static const std::regex from_table(R"(FROM\s+(\w+))");
+
+        if(std::regex_search(query, match, from_table)){
+            if(auto table = tables.find(match[1].str()); table != tables.end()){
+                result.code_to_map_field_value = table->second;
+            }
+        }
+
+        return result;
+    }
+
+    void FakeDatabase::ExecuteSchema(const std::string& name_connection, const std::string& query){
+        //Разбор без std::regex: рекурсивный поиск переполняет стек на схеме из тысяч столбцов
+        auto& tables = connection_to_tables_[name_connection];
+        auto& columns = connection_to_columns_[name_connection];
+
+        auto read_word = [](std::string_view text, size_t position){
+            size_t end = position;
+            while(end < text.size() && (std::isalnum(static_cast<unsigned char>(text[end])) || text[end] == '_')){
+                ++end;
+            }
+            return std::string(text.substr(position, end - position));
+        };
+
+        std::string_view rest = query;
+        while(!rest.empty()){
+            std::string_view statement = rest.substr(0, rest.find(';'));
+            rest.remove_prefix(std::min(rest.size(), statement.size() + 1));
+
+            if(size_t create = statement.find("CREATE TABLE "); create != std::string_view::npos){
+                size_t open = statement.find('(', create);
+                size_t close = statement.rfind(')');
+                std::string table = read_word(statement, create + 13);
+                tables[table];
+
+                if(open == std::string_view::npos || close == std::string_view::npos || close < open){
+                    continue;
+                }
+
+                //Определения столбцов разделены ", ", имя - первое слово определения
+                for(size_t position = open + 1; position < close;){
+                    columns[table].insert(read_word(statement, position));
+
+                    size_t next = statement.find(", ", position);
+                    position = (next == std::string_view::npos) ? close : next + 2;
+                }
+            }else if(size_t alter = statement.find("ALTER TABLE "); alter != std::string_view::npos){
+                std::string table = read_word(statement, alter + 12);
+
+                for(size_t position = statement.find("ADD COLUMN ", alter); position != std::string_view::npos; position = statement.find("ADD COLUMN ", position + 11)){
+                    columns[table].insert(read_word(statement, position + 11));
+                }
+            }
+        }
+    }
+
+}//namespace calc_server_bench
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DatabaseClient.h"
+
+namespace calc_server_bench{
+
+    using namespace database_client;
+
+    //Имя таблицы -> код -> столбец -> значение
+    using TablesData = std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>>;
+
+    //База данных в памяти процесса: запросы выполняются сразу при постановке в очередь.
+    //INSERT только подсчитываются, SELECT отвечают по information_schema и заранее заданным таблицам коэффициентов.
+    class FakeDatabase : public IDatabaseClient{
+    public:
+        struct Counters{
+            size_t inserts = 0;
+            size_t parameters = 0;
+            size_t bytes = 0;
+            size_t selects = 0;
+        };
+
+        //Таблицы, которые уже есть в подключении name_connection
+        void SetTables(const std::string& name_connection, TablesData tables);
+
+        //Таблицы и столбцы подключения name_connection в файле path, по одной паре "таблица столбец" в строке.
+        //Так схема переживает перезапуск процесса, как в настоящей базе
+        bool LoadSchema(const std::string& name_connection, const std::filesystem::path& path);
+        bool SaveSchema(const std::string& name_connection, const std::filesystem::path& path) const;
+
+        bool IsConfigRequired() const override{
+            return false;
+        }
+
+        [[nodiscard]] bool CreateConnectionDatabase(const ConnectionInfo& connection_info) override;
+
+        QueueResult InsertRequestInQueue(   const std::string& name_connection,
+                                            const std::string& query,
+                                            std::vector<std::string> values,
+                                            Command command,
+                                            const std::string& name_table
+        ) override;
+
+        ResultInsertRequest GetResultSelectFromID(int id_request) override;
+
+        //Очередь всегда занята: завершение запросов видно только по их id
+        void SetAlwaysBusy(bool always_busy){
+            always_busy_ = always_busy;
+        }
+
+        bool AreRequestsInProgress() override{
+            return always_busy_;
+        }
+
+        Counters GetCounters() const;
+
+    private:
+        ResultInsertRequest Select(const std::string& name_connection, const std::string& query, const std::string& name_table);
+        void ExecuteSchema(const std::string& name_connection, const std::string& query);
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, TablesData> connection_to_tables_;
+        //Подключение -> таблица -> столбцы, созданные CREATE TABLE и ADD COLUMN
+        std::unordered_map<std::string, std::unordered_map<std::string, std::set<std::string>>> connection_to_columns_;
+        std::unordered_map<int, ResultInsertRequest> id_to_result_;
+        int next_id_ = 0;
+        std::atomic<bool> always_busy_ = false;
+
+        Counters counters_;
+    };
+
+}//namespace calc_server_bench
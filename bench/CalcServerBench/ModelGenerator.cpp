@@ -0,0 +1,182 @@
+#include "ModelGenerator.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+namespace calc_server_bench{
+
+    using json = nlohmann::json;
+
+    GeneratedModel GenerateModel(const ModelSettings& settings, const std::string& type_block, const std::filesystem::path& path){
+        GeneratedModel model;
+        std::mt19937 random(settings.seed);
+
+        std::filesystem::create_directories(path);
+        for(const auto& entry : std::filesystem::directory_iterator(path)){
+            if(entry.path().extension() == ".json"){
+                std::filesystem::remove(entry.path());
+            }
+        }
+
+        for(size_t input = 0; input < std::max<size_t>(settings.count_inputs, 1); ++input){
+            model.kks_inputs.push_back("KKS_BENCH_" + std::to_string(input));
+            model.values_inputs.push_back(0.0);
+        }
+
+        for(size_t table = 0; table < settings.count_coefficient_tables; ++table){
+            auto& rows = model.coefficient_tables["bench_coef_" + std::to_string(table)];
+            for(size_t coefficient = 0; coefficient < settings.coefficients_per_table; ++coefficient){
+                rows["coef_" + std::to_string(table) + "_" + std::to_string(coefficient)]["k"] = "1.0";
+            }
+        }
+
+        std::uniform_int_distribution<size_t> pick_input(0, model.kks_inputs.size() - 1);
+        std::uniform_int_distribution<size_t> pick_coefficient(0, std::max<size_t>(settings.coefficients_per_table, 1) - 1);
+
+        json blocks = json::array();
+        size_t index_file = 0;
+
+        auto write_file = [&](){
+            if(blocks.empty()){
+                return;
+            }
+
+            std::ofstream file(path / ("model_" + std::to_string(index_file++) + ".json"));
+            if(!file.is_open()){
+                throw std::runtime_error("It is not possible to write the model to " + path.string());
+            }
+            file << blocks.dump();
+            blocks = json::array();
+        };
+
+        for(size_t block = 0; block < settings.count_blocks; ++block){
+            json inputs = json::array();
+            for(size_t input = 0; input < settings.inputs_per_block; ++input){
+                const std::string& kks = model.kks_inputs[pick_input(random)];
+                inputs.push_back({{"code", kks}, {"KKS", kks}, {"type", "d"}});
+            }
+
+            json coefficients = json::array();
+            if(settings.count_coefficient_tables != 0 && settings.coefficients_per_table != 0){
+                coefficients.push_back({
+                    {"table_name", "bench_coef_" + std::to_string(block % settings.count_coefficient_tables)},
+                    {"code_signals", json::array({{{"code", "coef_" + std::to_string(block % settings.count_coefficient_tables) + "_" + std::to_string(pick_coefficient(random))}, {"row", json::array({"k"})}}})}
+                });
+            }
+
+            json outputs = json::array();
+            for(size_t output = 0; output < settings.outputs_per_block; ++output){
+                std::string code = "OUT_" + std::to_string(block) + "_" + std::to_string(output);
+                outputs.push_back({
+                    {"code", code},
+                    {"table_col", "c_" + std::to_string(block) + "_" + std::to_string(output)},
+                    {"type", "d"},
+                    {"table_name", "bench_out_" + std::to_string(block % std::max<size_t>(settings.count_output_tables, 1))}
+                });
+            }
+
+            blocks.push_back({{"Type", type_block}, {"Inputs", inputs}, {"Coefficients", coefficients}, {"Outputs", outputs}});
+
+            if(blocks.size() >= settings.blocks_per_file){
+                write_file();
+            }
+        }
+
+        write_file();
+
+        return model;
+    }
+
+    namespace{
+
+        //Запись входных сигналов шага: все KKS или только изменившиеся
+        std::string BuildInputRecord(GeneratedModel& model, size_t step, double changed_fraction, std::mt19937& random, bool only_changed){
+            std::bernoulli_distribution changed(changed_fraction);
+
+            std::string content = "{";
+            bool first = true;
+            for(size_t input = 0; input < model.kks_inputs.size(); ++input){
+                //Неизменившиеся KKS сохраняют значение предыдущей записи
+                double& value = model.values_inputs[input];
+                bool is_changed = step == 0 || changed(random);
+                if(is_changed){
+                    value = static_cast<double>(step) + static_cast<double>(input) * 0.001;
+                }
+
+                if(only_changed && !is_changed){
+                    continue;
+                }
+
+                content += (first) ? "\"" : ",\"";
+                content += model.kks_inputs[input];
+                content += "\":";
+                content += std::to_string(value);
+                first = false;
+            }
+            content += "}";
+
+            return content;
+        }
+
+    }
+
+    void WriteInputFile(GeneratedModel& model, const std::filesystem::path& path, size_t step, double changed_fraction, std::mt19937& random){
+        std::string content = BuildInputRecord(model, step, changed_fraction, random, false);
+
+        std::filesystem::path path_temp = path;
+        path_temp += ".tmp";
+
+        {
+            std::ofstream file(path_temp, std::ios::trunc);
+            file << content;
+        }
+
+        std::filesystem::rename(path_temp, path);
+    }
+
+    void WriteReplayFile(GeneratedModel& model, const std::filesystem::path& path, size_t count_steps, double changed_fraction, std::mt19937& random){
+        std::ofstream file(path, std::ios::trunc);
+
+        for(size_t step = 0; step < count_steps; ++step){
+            file << BuildInputRecord(model, step, changed_fraction, random, true) << '\n';
+        }
+    }
+
+    size_t ChangeModel(const std::filesystem::path& path, size_t count_blocks){
+        std::filesystem::path path_model = path / "model_0.json";
+
+        json blocks;
+        {
+            std::ifstream file(path_model);
+            if(!file.is_open()){
+                throw std::runtime_error("It is not possible to read the model " + path_model.string());
+            }
+            blocks = json::parse(file);
+        }
+
+        size_t count_changed = std::min(count_blocks, blocks.size());
+        for(size_t block = 0; block < count_changed; ++block){
+            blocks[block]["Outputs"].push_back({
+                {"code", "OUT_RELOAD_" + std::to_string(block)},
+                {"table_col", "c_reload_" + std::to_string(block)},
+                {"type", "d"},
+                {"table_name", "bench_out_reload"}
+            });
+        }
+
+        std::filesystem::path path_temp = path_model;
+        path_temp += ".tmp";
+
+        {
+            std::ofstream file(path_temp, std::ios::trunc);
+            file << blocks.dump();
+        }
+
+        std::filesystem::rename(path_temp, path_model);
+
+        return count_changed;
+    }
+
+}//namespace calc_server_bench
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FakeDatabase.h"
+
+namespace calc_server_bench{
+
+    struct ModelSettings{
+        size_t count_blocks = 1000;
+        size_t inputs_per_block = 8;
+        size_t outputs_per_block = 2;
+        size_t count_inputs = 4000;             //Входы блоков выбираются из общего набора
+        size_t count_output_tables = 20;
+        size_t count_coefficient_tables = 5;
+        size_t coefficients_per_table = 200;
+        size_t blocks_per_file = 1000;
+        unsigned seed = 1;
+    };
+
+    struct GeneratedModel{
+        std::vector<std::string> kks_inputs;
+        std::vector<double> values_inputs;
+        TablesData coefficient_tables;
+    };
+
+    //Записывает модели в path (файлы model_N.json) в формате, который читает CalcServer::CreateBlocksFromJSON
+    GeneratedModel GenerateModel(const ModelSettings& settings, const std::string& type_block, const std::filesystem::path& path);
+
+    //Файл входных сигналов, в котором у доли changed_fraction KKS значение отличается от предыдущего шага
+    void WriteInputFile(GeneratedModel& model, const std::filesystem::path& path, size_t step, double changed_fraction, std::mt19937& random);
+
+    //Поток входных сигналов для CalcServer::RunReplay: строка на шаг, первая со всеми KKS, далее только изменившиеся
+    void WriteReplayFile(GeneratedModel& model, const std::filesystem::path& path, size_t count_steps, double changed_fraction, std::mt19937& random);
+
+    //Добавляет первым count_blocks блокам файла model_0.json выход в новую таблицу bench_out_reload, возвращает число изменённых блоков
+    size_t ChangeModel(const std::filesystem::path& path, size_t count_blocks);
+
+}//namespace calc_server_bench
@@ -0,0 +1,42 @@
+#include "DatabaseManagements.h"
+
+namespace database_managements{
+
+    ConnectionInfo ConnectionInfo::ConvertFromJSON(const nlohmann::json& config){
+        ConnectionInfo connection_info;
+
+        connection_info.dbname = config.value("DatabaseName", "");
+        connection_info.hostname = config.value("HostName", "");
+        connection_info.user = config.value("UserName", "");
+        connection_info.password = config.value("Password", "");
+        connection_info.port = config.value("Port", "");
+
+        return connection_info;
+    }
+
+    bool DatabaseManagements::CreateConnectionDatabase(const ConnectionInfo& connection_info){
+        return false;
+    }
+
+    ResultInsertQueue DatabaseManagements::InsertRequestInQueue(const char* name_connection,
+                                                                const char* query,
+                                                                std::vector<std::string> values,
+                                                                Command command,
+                                                                const std::string& name_table
+    ){
+        return {ResultRequest::kError, -1};
+    }
+
+    ResultInsertRequest DatabaseManagements::GetResultSelectFromID(int id_request){
+        return {};
+    }
+
+    bool DatabaseManagements::AreRequestsInProgress(){
+        return false;
+    }
+
+    size_t DatabaseManagements::GetSizeQueueSelect(){
+        return 0;
+    }
+
+}//namespace database_managements
@@ -0,0 +1,69 @@
+#pragma once
+
+//Замена внешней библиотеки DatabaseManagements для автономной сборки бенчмарка.
+//Содержит только то, что использует CalcServer; в бенчмарке запросы обслуживает FakeDatabase
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+//CalcServer рассчитывает на заголовки и литералы, которые приносит настоящий DatabaseManagements.h
+using namespace std::chrono_literals;
+
+namespace database_managements{
+
+    enum class Command{
+        kInsert,
+        kSelect
+    };
+
+    enum class ResultRequest{
+        kOk,
+        kInProcessing,
+        kError
+    };
+
+    struct ConnectionInfo{
+        std::string id_connection;
+        std::string dbname;
+        std::string hostname;
+        std::string user;
+        std::string password;
+        std::string port;
+
+        static ConnectionInfo ConvertFromJSON(const nlohmann::json& config);
+    };
+
+    struct ResultInsertQueue{
+        ResultRequest result_request = ResultRequest::kError;
+        int id_request = -1;
+    };
+
+    struct ResultInsertRequest{
+        int id_request = -1;
+        std::string name_table;
+        std::unordered_map<std::string, std::unordered_map<std::string, std::string>> code_to_map_field_value;
+    };
+
+    //Соединений нет: любая попытка работать с настоящей базой завершается ошибкой
+    class DatabaseManagements{
+    public:
+        bool CreateConnectionDatabase(const ConnectionInfo& connection_info);
+        ResultInsertQueue InsertRequestInQueue( const char* name_connection,
+                                                const char* query,
+                                                std::vector<std::string> values,
+                                                Command command,
+                                                const std::string& name_table
+        );
+        ResultInsertRequest GetResultSelectFromID(int id_request);
+        bool AreRequestsInProgress();
+        size_t GetSizeQueueSelect();
+    };
+
+}//namespace database_managements
@@ -0,0 +1,10 @@
+#include "LoadData.h"
+
+namespace load_data{
+
+    template<>
+    std::vector<DynamicLibrary> LoadAllFiles<DynamicLibrary>(const fs_path& path, const std::string& extension){
+        return {};
+    }
+
+}//namespace load_data
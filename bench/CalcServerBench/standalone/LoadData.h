@@ -0,0 +1,40 @@
+#pragma once
+
+//Замена внешней библиотеки LoadData для автономной сборки бенчмарка.
+//Бенчмарк регистрирует блоки через RegisterBlockType, поэтому подключаемые библиотеки не загружаются
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace load_data{
+
+    using fs_path = std::filesystem::path;
+
+    class DynamicLibrary{
+    public:
+        [[nodiscard]] const std::string& GetTypeDLL() const{
+            return type_dll_;
+        }
+
+        [[nodiscard]] const std::string& GetFileName() const{
+            return file_name_;
+        }
+
+        template<typename Function>
+        [[nodiscard]] Function GetFunction(const std::string& name_function) const{
+            return nullptr;
+        }
+
+    private:
+        std::string type_dll_;
+        std::string file_name_;
+    };
+
+    template<typename T>
+    std::vector<T> LoadAllFiles(const fs_path& path, const std::string& extension);
+
+    template<>
+    std::vector<DynamicLibrary> LoadAllFiles<DynamicLibrary>(const fs_path& path, const std::string& extension);
+
+}//namespace load_data
@@ -0,0 +1,39 @@
+#include "Logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace logger{
+
+    namespace{
+
+        const char* GetNameLevel(Logger::LogLevel level){
+            switch(level){
+                case Logger::LogLevel::kDebug:      return "DEBUG";
+                case Logger::LogLevel::kInfo:       return "INFO";
+                case Logger::LogLevel::kWarning:    return "WARNING";
+                case Logger::LogLevel::kError:      return "ERROR";
+                case Logger::LogLevel::kCritical:   return "CRITICAL";
+            }
+            return "UNKNOWN";
+        }
+
+    }//namespace
+
+    //Чтобы не мешать замерам, по умолчанию выводятся только предупреждения и ошибки;
+    //CALC_SERVER_BENCH_LOG_INFO включает и информационные сообщения
+    Logger::Logger(const std::string& name, bool is_write_console)
+        : name_(name)
+        , min_level_(std::getenv("CALC_SERVER_BENCH_LOG_INFO") != nullptr ? LogLevel::kInfo : LogLevel::kWarning)
+    {}
+
+    void Logger::log(const std::string& message, LogLevel level){
+        if(level < min_level_){
+            return;
+        }
+
+        std::lock_guard lock(mutex_);
+        std::fprintf(stderr, "[%s] %s: %s\n", name_.c_str(), GetNameLevel(level), message.c_str());
+    }
+
+}//namespace logger
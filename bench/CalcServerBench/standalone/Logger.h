@@ -0,0 +1,30 @@
+#pragma once
+
+//Замена внешней библиотеки Logger для автономной сборки бенчмарка: сообщения пишутся в stderr
+
+#include <string>
+#include <mutex>
+
+namespace logger{
+
+    class Logger{
+    public:
+        enum class LogLevel{
+            kDebug,
+            kInfo,
+            kWarning,
+            kError,
+            kCritical
+        };
+
+        Logger(const std::string& name, bool is_write_console);
+
+        void log(const std::string& message, LogLevel level = LogLevel::kDebug);
+
+    private:
+        std::string name_;
+        LogLevel min_level_;
+        std::mutex mutex_;
+    };
+
+}//namespace logger
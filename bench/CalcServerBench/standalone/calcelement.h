@@ -0,0 +1,62 @@
+#pragma once
+
+//Замена внешнего интерфейса calcelement для автономной сборки бенчмарка.
+//Содержит только поля и методы, к которым обращаются CalcServer и блоки бенчмарка
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+#include <nlohmann/json.hpp>
+
+namespace calc_element{
+
+    struct HighlightValue{
+        enum class Color{
+            kNone = 0
+        };
+
+        Color current_color = Color::kNone;
+    };
+
+    struct SignalInput{
+        enum class TypeSignals : char{
+            kTS_int = 'i',
+            kTS_double = 'd',
+            kTS_string = 's'
+        };
+
+        std::string code;
+        std::string kks;
+        TypeSignals type = TypeSignals::kTS_double;
+        std::variant<int, double, std::string> value;
+    };
+
+    struct SignalOutput{
+        std::string code;
+        std::string col_name;
+        std::string table_name;
+        std::variant<int, double, std::string> value;
+        HighlightValue highlight_value;
+        std::string id_problem;
+    };
+
+    struct Coefficient{
+        std::string code;
+        std::unordered_map<std::string, std::variant<double, std::string>> data_row;
+    };
+
+    using MapNameInputSignalToDataPtr =         std::unordered_map<std::string, const SignalInput*>;
+    using MapNameTableToValueCoefficientsPtr =  std::unordered_map<std::string, std::unordered_map<std::string, Coefficient*>>;
+    using MapNameTableToValueOutputSignalsPtr = std::unordered_map<std::string, std::unordered_map<std::string, SignalOutput*>>;
+
+    class ICalcElement{
+    public:
+        virtual ~ICalcElement() = default;
+
+        virtual void Process(double current_time, double step_calc) = 0;
+        virtual void GenerateDebugData(nlohmann::json& debug_data, double current_time, double step_calc) = 0;
+    };
+
+}//namespace calc_element
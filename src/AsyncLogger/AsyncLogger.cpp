@@ -0,0 +1,314 @@
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace async_logger{
+
+    AsyncLogger::AsyncLogger(const std::string& name_file, bool flag, size_t capacity, uint32_t max_per_interval, std::chrono::milliseconds interval)
+        :   sink_(name_file, flag),
+            max_per_interval_(max_per_interval),
+            interval_(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count())
+    {
+        size_t size = std::bit_ceil(std::max<size_t>(capacity, 2));
+        cells_ = std::make_unique<Cell[]>(size);
+        mask_ = size - 1;
+
+        for(size_t i = 0; i < size; ++i){
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        call_sites_ = std::make_unique<CallSite[]>(kCountCallSites);
+    }
+
+    AsyncLogger::~AsyncLogger(){
+        //Запасной путь, если Stop не был вызван: на Windows под loader lock ожидание потока может зависнуть
+        if(flusher_.joinable()){
+            {
+                std::lock_guard lock(mutex_flusher_);
+                count_starts_ = 1;
+            }
+            Stop();
+        }
+
+        ReportSuppressed(true);
+        WriteQueued();
+    }
+
+    void AsyncLogger::Start(){
+        std::lock_guard lock(mutex_flusher_);
+
+        if(count_starts_++ != 0){
+            return;
+        }
+
+        stop_ = false;
+        running_.store(true, std::memory_order_release);
+        flusher_ = std::thread(&AsyncLogger::FlusherLoop, this);
+    }
+
+    void AsyncLogger::Stop(){
+        {
+            std::lock_guard lock(mutex_flusher_);
+
+            if(count_starts_ == 0 || --count_starts_ != 0){
+                return;
+            }
+
+            //Новые сообщения пишутся сразу, фоновый поток дописывает очередь и завершается
+            running_.store(false, std::memory_order_release);
+            stop_ = true;
+        }
+
+        cv_flusher_.notify_one();
+        flusher_.join();
+
+        //Сообщения, поставленные в очередь между проверкой running_ и остановкой потока
+        WriteQueued();
+        cv_written_.notify_all();
+    }
+
+    void AsyncLogger::log(const std::string& message, LogLevel level){
+        Push(std::string(message), level);
+    }
+
+    int64_t AsyncLogger::Now(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    AsyncLogger::CallSite* AsyncLogger::FindCallSite(const std::source_location& location){
+        //Строка с именем файла у одного места вызова всегда одна и та же, поэтому ключ - её адрес и номер строки
+        uint64_t key = (reinterpret_cast<uintptr_t>(location.file_name()) * 0x9E3779B97F4A7C15ull) ^ location.line();
+        key = (key == 0) ? 1 : key;
+
+        for(size_t probe = 0; probe < kCountCallSites; ++probe){
+            CallSite& site = call_sites_[(key + probe) & (kCountCallSites - 1)];
+            uint64_t current = site.key.load(std::memory_order_acquire);
+
+            if(current == key){
+                return &site;
+            }
+
+            if(current == 0){
+                if(site.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)){
+                    site.line.store(location.line(), std::memory_order_relaxed);
+                    site.file_name.store(location.file_name(), std::memory_order_release);
+                    site.window_start.store(Now(), std::memory_order_relaxed);
+                    return &site;
+                }
+
+                if(current == key){
+                    return &site;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    AsyncLogger::CallSite* AsyncLogger::Admit(const std::source_location& location){
+        CallSite* site = FindCallSite(location);
+
+        //Таблица мест вызова заполнена - ограничение не действует
+        if(site == nullptr){
+            return &call_site_unlimited_;
+        }
+
+        int64_t now = Now();
+        int64_t window_start = site->window_start.load(std::memory_order_relaxed);
+
+        if(now - window_start >= interval_){
+            ResetWindow(*site, window_start, now);
+        }
+
+        if(site->count_in_window.fetch_add(1, std::memory_order_relaxed) < max_per_interval_){
+            return site;
+        }
+
+        site->suppressed.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    void AsyncLogger::RememberMessage(CallSite& site, const std::string& message){
+        //Не больше max_per_interval раз за interval на место вызова
+        std::lock_guard lock(site.mutex_message);
+        site.last_message = message;
+    }
+
+    void AsyncLogger::ResetWindow(CallSite& site, int64_t window_start, int64_t now){
+        if(!site.window_start.compare_exchange_strong(window_start, now, std::memory_order_relaxed)){
+            return;
+        }
+
+        site.count_in_window.store(0, std::memory_order_relaxed);
+
+        uint64_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        if(suppressed == 0){
+            return;
+        }
+
+        std::string message = "The message \"";
+        {
+            std::lock_guard lock(site.mutex_message);
+            message += site.last_message;
+        }
+
+        const char* file_name = site.file_name.load(std::memory_order_acquire);
+        message += "\" and similar from ";
+        message += (file_name != nullptr) ? file_name : "?";
+        message += ":" + std::to_string(site.line.load(std::memory_order_relaxed)) + " repeated " + std::to_string(suppressed) + " times";
+
+        Push(std::move(message), LogLevel::kWarning);
+    }
+
+    void AsyncLogger::Push(std::string&& message, LogLevel level){
+        if(!running_.load(std::memory_order_acquire)){
+            std::lock_guard lock(mutex_sink_);
+            sink_.log(message, level);
+            return;
+        }
+
+        if(!TryPush(std::move(message), level)){
+            return;
+        }
+
+        //Пара к проверке очереди фоновым потоком перед ожиданием: либо он увидит сообщение, либо мы - его ожидание
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if(flusher_waiting_.load(std::memory_order_relaxed)){
+            std::lock_guard lock(mutex_flusher_);
+            cv_flusher_.notify_one();
+        }
+    }
+
+    bool AsyncLogger::TryPush(std::string&& message, LogLevel level){
+        Cell* cell;
+        size_t position = position_push_.load(std::memory_order_relaxed);
+
+        while(true){
+            cell = &cells_[position & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if(difference == 0){
+                if(position_push_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(difference < 0){
+                count_dropped_.fetch_add(1, std::memory_order_relaxed);
+                count_dropped_total_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }else{
+                position = position_push_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->level = level;
+        cell->message = std::move(message);
+        count_pushed_.fetch_add(1, std::memory_order_relaxed);
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool AsyncLogger::Pop(std::string& message, LogLevel& level){
+        //Читает один поток: фоновый, а после его остановки - Stop или деструктор
+        size_t position = position_pop_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[position & mask_];
+
+        if(cell.sequence.load(std::memory_order_acquire) != position + 1){
+            return false;
+        }
+
+        message = std::move(cell.message);
+        cell.message.clear();
+        level = cell.level;
+
+        position_pop_.store(position + 1, std::memory_order_relaxed);
+        cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool AsyncLogger::IsQueueEmpty() const{
+        size_t position = position_pop_.load(std::memory_order_relaxed);
+        return cells_[position & mask_].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    void AsyncLogger::WriteQueued(){
+        std::string message;
+        LogLevel level;
+
+        std::lock_guard lock(mutex_sink_);
+
+        while(Pop(message, level)){
+            sink_.log(message, level);
+            count_written_.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void AsyncLogger::ReportSuppressed(bool force){
+        int64_t now = Now();
+
+        for(size_t i = 0; i < kCountCallSites; ++i){
+            CallSite& site = call_sites_[i];
+
+            if(site.key.load(std::memory_order_relaxed) == 0 || site.suppressed.load(std::memory_order_relaxed) == 0){
+                continue;
+            }
+
+            int64_t window_start = site.window_start.load(std::memory_order_relaxed);
+            if(force || now - window_start >= interval_){
+                ResetWindow(site, window_start, now);
+            }
+        }
+
+        if(size_t dropped = count_dropped_.exchange(0, std::memory_order_relaxed); dropped != 0){
+            Push("The log queue is full, messages dropped: " + std::to_string(dropped), LogLevel::kWarning);
+        }
+    }
+
+    void AsyncLogger::FlusherLoop(){
+        constexpr std::chrono::milliseconds kReportInterval{100};
+        auto last_report = std::chrono::steady_clock::now();
+
+        std::unique_lock lock(mutex_flusher_);
+
+        while(true){
+            bool stop = stop_;
+            lock.unlock();
+
+            if(stop){
+                ReportSuppressed(true);
+            }else if(std::chrono::steady_clock::now() - last_report >= kReportInterval){
+                ReportSuppressed(false);
+                last_report = std::chrono::steady_clock::now();
+            }
+
+            WriteQueued();
+
+            lock.lock();
+            cv_written_.notify_all();
+
+            if(stop){
+                return;
+            }
+
+            //Повторы выводятся по окончании окна, поэтому ожидание ограничено интервалом отчёта
+            flusher_waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv_flusher_.wait_for(lock, kReportInterval, [this](){ return stop_ || !IsQueueEmpty(); });
+            flusher_waiting_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void AsyncLogger::Flush(){
+        size_t target = count_pushed_.load(std::memory_order_acquire);
+
+        std::unique_lock lock(mutex_flusher_);
+        cv_written_.wait(lock, [this, target](){
+            return count_written_.load(std::memory_order_acquire) >= target || !running_.load(std::memory_order_acquire);
+        });
+    }
+
+}//namespace async_logger
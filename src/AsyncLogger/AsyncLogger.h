@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <thread>
+
+#include "Logger.h"
+
+namespace async_logger{
+
+    using LogLevel = logger::Logger::LogLevel;
+
+    //Журнал, который не блокирует вызывающий поток.
+    //Сообщения попадают в ограниченную lock-free очередь (Д. Вьюков, bounded MPMC queue), в файл их пишет фоновый поток.
+    //log пишет каждое сообщение. LogLazy предназначен для мест вызова на пути шага: для каждого места (файл и строка)
+    //пропускается не больше max_per_interval сообщений за interval, остальные только считаются и выводятся одной строкой
+    //с текстом последнего записанного сообщения этого места и числом повторов.
+    //Если очередь заполнена, сообщение отбрасывается, число отброшенных выводится фоновым потоком.
+    //
+    //Фоновый поток работает между Start и Stop (вызовы парные, поток останавливает последний Stop).
+    //Вне этого интервала сообщения пишутся сразу в вызывающем потоке. Stop вызывается явно до выгрузки библиотеки:
+    //ожидание потока в деструкторе глобального объекта под loader lock Windows может зависнуть.
+    class AsyncLogger{
+    public:
+        AsyncLogger(const std::string& name_file, bool flag,
+                    size_t capacity = 8192,
+                    uint32_t max_per_interval = 10,
+                    std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+        ~AsyncLogger();
+
+        AsyncLogger(const AsyncLogger& other) = delete;
+        AsyncLogger& operator=(const AsyncLogger& other) = delete;
+
+        void Start();
+        void Stop();
+
+        void log(const std::string& message, LogLevel level = LogLevel::kDebug);
+
+        //Сообщение формируется, только если место вызова не превысило ограничение
+        template<typename Formatter>
+        void LogLazy(LogLevel level, Formatter&& make_message, std::source_location location = std::source_location::current()){
+            if(CallSite* site = Admit(location); site != nullptr){
+                std::string message = make_message();
+                RememberMessage(*site, message);
+                Push(std::move(message), level);
+            }
+        }
+
+        //Ждёт, пока фоновый поток запишет все сообщения, поставленные до вызова
+        void Flush();
+
+        size_t GetCountDropped() const{
+            return count_dropped_total_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Cell{
+            std::atomic<size_t> sequence;
+            LogLevel level;
+            std::string message;
+        };
+
+        struct CallSite{
+            std::atomic<uint64_t> key{0};
+            std::atomic<const char*> file_name{nullptr};
+            std::atomic<uint32_t> line{0};
+            std::atomic<int64_t> window_start{0};
+            std::atomic<uint32_t> count_in_window{0};
+            std::atomic<uint64_t> suppressed{0};
+
+            //Последнее записанное сообщение, для строки о повторах
+            std::mutex mutex_message;
+            std::string last_message;
+        };
+
+        static constexpr size_t kCountCallSites = 4096;
+
+        //nullptr - сообщение не пропускается
+        CallSite* Admit(const std::source_location& location);
+        CallSite* FindCallSite(const std::source_location& location);
+        void RememberMessage(CallSite& site, const std::string& message);
+        void ResetWindow(CallSite& site, int64_t window_start, int64_t now);
+        static int64_t Now();
+
+        void Push(std::string&& message, LogLevel level);
+        bool TryPush(std::string&& message, LogLevel level);
+        bool Pop(std::string& message, LogLevel& level);
+        bool IsQueueEmpty() const;
+        void WriteQueued();
+        void FlusherLoop();
+        //Выводит накопленные повторы мест вызова, у которых закончилось окно (force - у всех)
+        void ReportSuppressed(bool force);
+
+        logger::Logger sink_;
+        //Запись в sink_ из вызывающих потоков, пока фоновый поток не работает
+        std::mutex mutex_sink_;
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+        alignas(64) std::atomic<size_t> position_push_{0};
+        alignas(64) std::atomic<size_t> position_pop_{0};
+
+        std::unique_ptr<CallSite[]> call_sites_;
+        //Место вызова без ограничения, если таблица мест заполнена
+        CallSite call_site_unlimited_;
+        uint32_t max_per_interval_;
+        int64_t interval_;
+
+        std::atomic<size_t> count_dropped_{0};
+        std::atomic<size_t> count_dropped_total_{0};
+        std::atomic<size_t> count_written_{0};
+        std::atomic<size_t> count_pushed_{0};
+
+        std::mutex mutex_flusher_;
+        std::condition_variable cv_flusher_;
+        std::condition_variable cv_written_;
+        std::atomic<bool> flusher_waiting_{false};
+        std::atomic<bool> running_{false};
+        bool stop_ = false;
+        size_t count_starts_ = 0;
+
+        std::thread flusher_;
+    };
+
+    //Start в конструкторе и Stop в деструкторе. Объявляется первым членом класса,
+    //чтобы поток журнала остановился после потоков остальных членов.
+    class LoggerSession{
+    public:
+        explicit LoggerSession(AsyncLogger& logger) : logger_(logger){
+            logger_.Start();
+        }
+
+        ~LoggerSession(){
+            logger_.Stop();
+        }
+
+        LoggerSession(const LoggerSession& other) = delete;
+        LoggerSession& operator=(const LoggerSession& other) = delete;
+
+    private:
+        AsyncLogger& logger_;
+    };
+
+}//namespace async_logger
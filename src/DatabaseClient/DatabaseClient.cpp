@@ -0,0 +1,34 @@
+#include "DatabaseClient.h"
+
+namespace database_client{
+
+    bool DatabaseManagementsClient::CreateConnectionDatabase(const ConnectionInfo& connection_info){
+        return db_manager_.CreateConnectionDatabase(connection_info);
+    }
+
+    IDatabaseClient::QueueResult DatabaseManagementsClient::InsertRequestInQueue(   const std::string& name_connection,
+                                                                                    const std::string& query,
+                                                                                    std::vector<std::string> values,
+                                                                                    Command command,
+                                                                                    const std::string& name_table
+    ){
+        auto result_insert = db_manager_.InsertRequestInQueue(
+                                    name_connection.data(),
+                                    query.data(),
+                                    std::move(values),
+                                    command,
+                                    name_table
+                                );
+
+        return {result_insert.result_request, result_insert.id_request};
+    }
+
+    ResultInsertRequest DatabaseManagementsClient::GetResultSelectFromID(int id_request){
+        return db_manager_.GetResultSelectFromID(id_request);
+    }
+
+    bool DatabaseManagementsClient::AreRequestsInProgress(){
+        return db_manager_.AreRequestsInProgress();
+    }
+
+}//namespace database_client
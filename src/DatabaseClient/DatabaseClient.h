@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DatabaseManagements.h"
+
+namespace database_client{
+
+    using namespace database_managements;
+
+    //Всё, что CalcServer использует от базы данных. Позволяет подменить DatabaseManagements,
+    //например, находящимся в процессе хранилищем для замеров без PostgreSQL.
+    class IDatabaseClient{
+    public:
+        struct QueueResult{
+            ResultRequest result_request = ResultRequest::kError;
+            int id_request = -1;
+        };
+
+        virtual ~IDatabaseClient() = default;
+
+        //false - подключение не требует настроек из "ConfigDB.json"
+        virtual bool IsConfigRequired() const{
+            return true;
+        }
+
+        [[nodiscard]] virtual bool CreateConnectionDatabase(const ConnectionInfo& connection_info) = 0;
+
+        virtual QueueResult InsertRequestInQueue(   const std::string& name_connection,
+                                                    const std::string& query,
+                                                    std::vector<std::string> values,
+                                                    Command command,
+                                                    const std::string& name_table
+        ) = 0;
+
+        //id_request результата -1, если результат ещё не готов
+        virtual ResultInsertRequest GetResultSelectFromID(int id_request) = 0;
+
+        virtual bool AreRequestsInProgress() = 0;
+    };
+
+    class DatabaseManagementsClient : public IDatabaseClient{
+    public:
+        [[nodiscard]] bool CreateConnectionDatabase(const ConnectionInfo& connection_info) override;
+
+        QueueResult InsertRequestInQueue(   const std::string& name_connection,
+                                            const std::string& query,
+                                            std::vector<std::string> values,
+                                            Command command,
+                                            const std::string& name_table
+        ) override;
+
+        ResultInsertRequest GetResultSelectFromID(int id_request) override;
+
+        bool AreRequestsInProgress() override;
+
+    private:
+        DatabaseManagements db_manager_;
+    };
+
+}//namespace database_client
@@ -0,0 +1,297 @@
+#include "InputFileWatcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace input_signals{
+
+    MappedFile::~MappedFile(){
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept{
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept{
+        if(this != &other){
+            Close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            #ifdef _WIN32
+                handle_file_ = std::exchange(other.handle_file_, nullptr);
+                handle_mapping_ = std::exchange(other.handle_mapping_, nullptr);
+            #endif
+        }
+        return *this;
+    }
+
+    #ifdef _WIN32
+
+    bool MappedFile::Open(const std::filesystem::path& path){
+        Close();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        LARGE_INTEGER size_file;
+        if(!GetFileSizeEx(file, &size_file)){
+            CloseHandle(file);
+            return false;
+        }
+
+        handle_file_ = file;
+
+        if(size_file.QuadPart == 0){
+            return true;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping == nullptr){
+            Close();
+            return false;
+        }
+
+        handle_mapping_ = mapping;
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(view == nullptr){
+            Close();
+            return false;
+        }
+
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(size_file.QuadPart);
+
+        return true;
+    }
+
+    void MappedFile::Close(){
+        if(data_ != nullptr){
+            UnmapViewOfFile(data_);
+        }
+        if(handle_mapping_ != nullptr){
+            CloseHandle(handle_mapping_);
+        }
+        if(handle_file_ != nullptr){
+            CloseHandle(handle_file_);
+        }
+
+        data_ = nullptr;
+        size_ = 0;
+        handle_mapping_ = nullptr;
+        handle_file_ = nullptr;
+    }
+
+    bool ReadFileContent(const std::filesystem::path& path, std::string& buffer){
+        buffer.clear();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE){
+            return false;
+        }
+
+        LARGE_INTEGER size_file;
+        if(!GetFileSizeEx(file, &size_file)){
+            CloseHandle(file);
+            return false;
+        }
+
+        //Файл может вырасти во время чтения, поэтому читается до конца, а не ровно size_file байт
+        buffer.resize(static_cast<size_t>(size_file.QuadPart) + 1);
+        size_t size_read = 0;
+        bool result = true;
+
+        while(true){
+            if(size_read == buffer.size()){
+                buffer.resize(buffer.size() * 2);
+            }
+
+            DWORD count_read = 0;
+            DWORD count_request = static_cast<DWORD>(std::min<size_t>(buffer.size() - size_read, MAXDWORD));
+            if(!::ReadFile(file, buffer.data() + size_read, count_request, &count_read, nullptr)){
+                result = false;
+                break;
+            }
+            if(count_read == 0){
+                break;
+            }
+            size_read += count_read;
+        }
+
+        CloseHandle(file);
+        buffer.resize(size_read);
+
+        return result;
+    }
+
+    #else
+
+    bool MappedFile::Open(const std::filesystem::path& path){
+        Close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd == -1){
+            return false;
+        }
+
+        struct stat stat_file;
+        if(::fstat(fd, &stat_file) == -1){
+            ::close(fd);
+            return false;
+        }
+
+        if(stat_file.st_size == 0){
+            ::close(fd);
+            return true;
+        }
+
+        void* view = ::mmap(nullptr, static_cast<size_t>(stat_file.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if(view == MAP_FAILED){
+            return false;
+        }
+
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(stat_file.st_size);
+
+        return true;
+    }
+
+    void MappedFile::Close(){
+        if(data_ != nullptr){
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    bool ReadFileContent(const std::filesystem::path& path, std::string& buffer){
+        buffer.clear();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd == -1){
+            return false;
+        }
+
+        struct stat stat_file;
+        if(::fstat(fd, &stat_file) == -1){
+            ::close(fd);
+            return false;
+        }
+
+        //Файл может вырасти во время чтения, поэтому читается до конца, а не ровно st_size байт
+        buffer.resize(static_cast<size_t>(stat_file.st_size) + 1);
+        size_t size_read = 0;
+        bool result = true;
+
+        while(true){
+            if(size_read == buffer.size()){
+                buffer.resize(buffer.size() * 2);
+            }
+
+            ssize_t count_read = ::read(fd, buffer.data() + size_read, buffer.size() - size_read);
+            if(count_read == -1){
+                if(errno == EINTR){
+                    continue;
+                }
+                result = false;
+                break;
+            }
+            if(count_read == 0){
+                break;
+            }
+            size_read += static_cast<size_t>(count_read);
+        }
+
+        ::close(fd);
+        buffer.resize(size_read);
+
+        return result;
+    }
+
+    #endif
+
+    uint64_t HashContent(std::string_view content){
+        //FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for(unsigned char symbol : content){
+            hash ^= symbol;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    InputFileWatcher::InputFileWatcher(std::filesystem::path path) : path_(std::move(path)){}
+
+    void InputFileWatcher::SetPath(std::filesystem::path path){
+        if(path == path_){
+            return;
+        }
+
+        path_ = std::move(path);
+        Reset();
+    }
+
+    void InputFileWatcher::Reset(){
+        has_state_ = false;
+        is_racy_ = false;
+    }
+
+    InputFileWatcher::StateFile InputFileWatcher::CheckChanges(){
+        std::error_code error;
+
+        auto write_time = std::filesystem::last_write_time(path_, error);
+        if(error){
+            return StateFile::kError;
+        }
+
+        auto size_file = std::filesystem::file_size(path_, error);
+        if(error){
+            return StateFile::kError;
+        }
+
+        if(has_state_ && !is_racy_ && write_time == last_write_time_ && size_file == size_){
+            return StateFile::kUnchanged;
+        }
+
+        auto read_time = std::filesystem::file_time_type::clock::now();
+
+        if(!ReadFileContent(path_, content_)){
+            return StateFile::kError;
+        }
+
+        uint64_t hash = HashContent(content_);
+
+        bool changed = !has_state_ || hash != hash_;
+
+        last_write_time_ = write_time;
+        size_ = size_file;
+        hash_ = hash;
+        has_state_ = true;
+        is_racy_ = write_time + kRacyInterval >= read_time;
+
+        return (changed) ? StateFile::kChanged : StateFile::kUnchanged;
+    }
+
+}//namespace input_signals
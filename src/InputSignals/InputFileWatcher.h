@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace input_signals{
+
+    //Отображение файла в память только для чтения. Содержимое действительно до следующего Open/Close.
+    //Только для файлов, которые не перезаписываются на месте во время чтения (модели, снимки).
+    class MappedFile{
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        [[nodiscard]] bool Open(const std::filesystem::path& path);
+        void Close();
+
+        std::string_view GetContent() const{
+            return {data_, size_};
+        }
+
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+
+        #ifdef _WIN32
+            void* handle_file_ = nullptr;
+            void* handle_mapping_ = nullptr;
+        #endif
+    };
+
+    //Чтение файла целиком в буфер, ёмкость буфера переиспользуется между вызовами.
+    //Для файлов, которые внешний процесс может перезаписывать на месте: усечение файла
+    //во время чтения даёт короткое содержимое, а не SIGBUS, как при отображении в память.
+    [[nodiscard]] bool ReadFileContent(const std::filesystem::path& path, std::string& buffer);
+
+    uint64_t HashContent(std::string_view content);
+
+    class InputFileWatcher{
+    public:
+        enum class StateFile{
+            kUnchanged,
+            kChanged,
+            kError
+        };
+
+        InputFileWatcher() = default;
+        explicit InputFileWatcher(std::filesystem::path path);
+
+        void SetPath(std::filesystem::path path);
+        const std::filesystem::path& GetPath() const{
+            return path_;
+        }
+
+        //Сначала сравниваются время изменения и размер файла, и только если они отличаются,
+        //файл читается и сравнивается хэш содержимого. Если файл был изменён в пределах
+        //kRacyInterval до прошлого чтения, хэш проверяется и при совпадении времени и размера:
+        //перезапись того же размера в тот же тик времени изменения иначе не была бы замечена.
+        [[nodiscard]] StateFile CheckChanges();
+
+        //Содержимое, прочитанное последним вызовом CheckChanges, вернувшим kChanged.
+        std::string_view GetContent() const{
+            return content_;
+        }
+
+        //Следующий CheckChanges вернёт kChanged, даже если файл не менялся.
+        void Reset();
+
+    private:
+        //Грубее всех распространённых ФС (у FAT время изменения хранится с точностью 2 с)
+        static constexpr std::chrono::seconds kRacyInterval{2};
+
+        std::filesystem::path path_;
+        std::filesystem::file_time_type last_write_time_{};
+        uintmax_t size_ = 0;
+        uint64_t hash_ = 0;
+        bool has_state_ = false;
+        //Время изменения было близко к моменту чтения, совпадение времени и размера ничего не гарантирует
+        bool is_racy_ = false;
+
+        std::string content_;
+    };
+
+}//namespace input_signals
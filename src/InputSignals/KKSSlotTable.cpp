@@ -0,0 +1,237 @@
+#include "KKSSlotTable.h"
+
+#include <bit>
+
+#include "InputFileWatcher.h"
+
+namespace input_signals{
+
+    namespace{
+
+        using json = nlohmann::json;
+
+        //Разбирает только верхний уровень объекта {"KKS": value, ...}, вложенные значения пропускаются
+        class SaxSlotWriter{
+        public:
+            explicit SaxSlotWriter(KKSSlotTable& table) : table_(table){}
+
+            bool null(){
+                return true;
+            }
+
+            bool boolean(bool){
+                return true;
+            }
+
+            bool number_integer(json::number_integer_t value){
+                if(IsTargetValue()){
+                    table_.SetValue(current_slot_, static_cast<int>(value));
+                }
+                return true;
+            }
+
+            bool number_unsigned(json::number_unsigned_t value){
+                if(IsTargetValue()){
+                    table_.SetValue(current_slot_, static_cast<int>(value));
+                }
+                return true;
+            }
+
+            bool number_float(json::number_float_t value, const json::string_t&){
+                if(IsTargetValue()){
+                    table_.SetValue(current_slot_, static_cast<double>(value));
+                }
+                return true;
+            }
+
+            bool string(json::string_t& value){
+                if(IsTargetValue()){
+                    table_.SetValue(current_slot_, std::string_view(value));
+                }
+                return true;
+            }
+
+            bool binary(json::binary_t&){
+                return true;
+            }
+
+            bool start_object(std::size_t){
+                ++depth_;
+                return true;
+            }
+
+            bool key(json::string_t& value){
+                if(depth_ == 1){
+                    current_slot_ = table_.FindSlot(value);
+                }
+                return true;
+            }
+
+            bool end_object(){
+                --depth_;
+                return true;
+            }
+
+            bool start_array(std::size_t){
+                ++depth_;
+                return true;
+            }
+
+            bool end_array(){
+                --depth_;
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&){
+                return false;
+            }
+
+        private:
+            bool IsTargetValue() const{
+                return depth_ == 1 && current_slot_ != KKSSlotTable::kNotFound;
+            }
+
+            KKSSlotTable& table_;
+            int depth_ = 0;
+            int current_slot_ = KKSSlotTable::kNotFound;
+        };
+
+    }
+
+    void KKSSlotTable::Clear(){
+        slots_.clear();
+        buckets_.clear();
+        mask_buckets_ = 0;
+        updated_slots_.clear();
+        changed_signals_.clear();
+    }
+
+    void KKSSlotTable::Build(const MapKKSToSetPtr& kks_to_signals){
+        Clear();
+
+        slots_.reserve(kks_to_signals.size());
+        for(const auto& [kks, set_signals] : kks_to_signals){
+            Slot& slot = slots_.emplace_back();
+            slot.kks = kks;
+            slot.signals.assign(set_signals.begin(), set_signals.end());
+        }
+
+        //Открытая адресация с линейным пробированием, заполнение не больше половины
+        size_t count_buckets = std::bit_ceil(std::max<size_t>(slots_.size() * 2, 16));
+        buckets_.assign(count_buckets, Bucket{});
+        mask_buckets_ = count_buckets - 1;
+
+        for(int index_slot = 0; index_slot < static_cast<int>(slots_.size()); ++index_slot){
+            uint64_t hash = HashContent(slots_[index_slot].kks);
+            uint64_t position = hash & mask_buckets_;
+
+            while(buckets_[position].slot != kNotFound){
+                position = (position + 1) & mask_buckets_;
+            }
+
+            buckets_[position] = {hash, index_slot};
+        }
+
+        updated_slots_.reserve(slots_.size());
+    }
+
+    int KKSSlotTable::FindSlot(std::string_view kks) const{
+        if(buckets_.empty()){
+            return kNotFound;
+        }
+
+        uint64_t hash = HashContent(kks);
+        uint64_t position = hash & mask_buckets_;
+
+        while(buckets_[position].slot != kNotFound){
+            const Bucket& bucket = buckets_[position];
+            if(bucket.hash == hash && slots_[bucket.slot].kks == kks){
+                return bucket.slot;
+            }
+            position = (position + 1) & mask_buckets_;
+        }
+
+        return kNotFound;
+    }
+
+    void KKSSlotTable::BeginUpdate(){
+        updated_slots_.clear();
+        ++epoch_;
+    }
+
+    KKSSlotTable::Slot* KKSSlotTable::StageSlot(int slot){
+        Slot* target = &slots_[slot];
+
+        if(target->update_epoch != epoch_){
+            target->update_epoch = epoch_;
+            updated_slots_.push_back(slot);
+        }
+
+        return target;
+    }
+
+    void KKSSlotTable::SetValue(int slot, int value){
+        Slot* target = StageSlot(slot);
+        target->type_value = TypeValue::kInt;
+        target->value_int = value;
+    }
+
+    void KKSSlotTable::SetValue(int slot, double value){
+        Slot* target = StageSlot(slot);
+        target->type_value = TypeValue::kDouble;
+        target->value_double = value;
+    }
+
+    void KKSSlotTable::SetValue(int slot, std::string_view value){
+        Slot* target = StageSlot(slot);
+        target->type_value = TypeValue::kString;
+        target->value_string.assign(value);
+    }
+
+    size_t KKSSlotTable::CommitUpdate(){
+        size_t count_changed = 0;
+
+        for(int index_slot : updated_slots_){
+            const Slot& slot = slots_[index_slot];
+
+            for(auto* signal : slot.signals){
+                if(slot.type_value == TypeValue::kInt){
+                    if(const int* current = std::get_if<int>(&signal->value); current != nullptr && *current == slot.value_int){
+                        continue;
+                    }
+                    signal->value = slot.value_int;
+                }else if(slot.type_value == TypeValue::kDouble){
+                    if(const double* current = std::get_if<double>(&signal->value); current != nullptr && *current == slot.value_double){
+                        continue;
+                    }
+                    signal->value = slot.value_double;
+                }else if(slot.type_value == TypeValue::kString){
+                    if(const std::string* current = std::get_if<std::string>(&signal->value); current != nullptr && *current == slot.value_string){
+                        continue;
+                    }
+                    signal->value = slot.value_string;
+                }else{
+                    continue;
+                }
+
+                changed_signals_.push_back(signal);
+                ++count_changed;
+            }
+        }
+
+        return count_changed;
+    }
+
+    void KKSSlotTable::DiscardUpdate(){
+        for(int index_slot : updated_slots_){
+            slots_[index_slot].update_epoch = 0;
+        }
+        updated_slots_.clear();
+    }
+
+    bool KKSSlotTable::ParseJSON(std::string_view content){
+        SaxSlotWriter writer(*this);
+        return json::sax_parse(content.data(), content.data() + content.size(), &writer);
+    }
+
+}//namespace input_signals
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "calcelement.h"
+
+namespace input_signals{
+
+    //Таблица KKS -> слот, собирается один раз после загрузки моделей.
+    //Значения из входного файла разбираются SAX-парсером сразу в слоты без построения DOM.
+    class KKSSlotTable{
+    public:
+        static constexpr int kNotFound = -1;
+
+        using MapKKSToSetPtr = std::unordered_map<std::string, std::set<calc_element::SignalInput*>>;
+
+        void Build(const MapKKSToSetPtr& kks_to_signals);
+        void Clear();
+
+        int FindSlot(std::string_view kks) const;
+
+        size_t GetCountSlots() const{
+            return slots_.size();
+        }
+
+        const std::string& GetKKS(int slot) const{
+            return slots_[slot].kks;
+        }
+
+        //Значения сначала накапливаются, а в SignalInput попадают только при CommitUpdate,
+        //чтобы недописанный файл не применялся частично.
+        void BeginUpdate();
+        void SetValue(int slot, int value);
+        void SetValue(int slot, double value);
+        void SetValue(int slot, std::string_view value);
+        size_t CommitUpdate();
+        void DiscardUpdate();
+
+        //Получал ли слот значение в последнем обновлении
+        bool IsUpdated(int slot) const{
+            return slots_[slot].update_epoch == epoch_;
+        }
+
+        //Сигналы, значения которых изменились при CommitUpdate с момента последнего ClearChangedSignals
+        const std::vector<const calc_element::SignalInput*>& GetChangedSignals() const{
+            return changed_signals_;
+        }
+
+        void ClearChangedSignals(){
+            changed_signals_.clear();
+        }
+
+        [[nodiscard]] bool ParseJSON(std::string_view content);
+
+    private:
+        enum class TypeValue : uint8_t{
+            kNone,
+            kInt,
+            kDouble,
+            kString
+        };
+
+        struct Slot{
+            std::string kks;
+            std::vector<calc_element::SignalInput*> signals;
+
+            TypeValue type_value = TypeValue::kNone;
+            int value_int = 0;
+            double value_double = 0.0;
+            std::string value_string;
+
+            uint32_t update_epoch = 0;
+        };
+
+        struct Bucket{
+            uint64_t hash = 0;
+            int slot = kNotFound;
+        };
+
+        Slot* StageSlot(int slot);
+
+        std::vector<Slot> slots_;
+        std::vector<Bucket> buckets_;
+        uint64_t mask_buckets_ = 0;
+
+        std::vector<int> updated_slots_;
+        uint32_t epoch_ = 0;
+
+        std::vector<const calc_element::SignalInput*> changed_signals_;
+    };
+
+}//namespace input_signals
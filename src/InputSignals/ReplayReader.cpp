@@ -0,0 +1,46 @@
+#include "ReplayReader.h"
+
+namespace input_signals{
+
+    bool ReplayReader::Open(const std::filesystem::path& path){
+        Close();
+
+        if(!file_.Open(path)){
+            return false;
+        }
+
+        content_ = file_.GetContent();
+        return true;
+    }
+
+    void ReplayReader::Close(){
+        file_.Close();
+        content_ = {};
+        position_ = 0;
+        line_number_ = 0;
+    }
+
+    bool ReplayReader::NextLine(std::string_view& line){
+        while(position_ < content_.size()){
+            size_t end = content_.find('\n', position_);
+            if(end == std::string_view::npos){
+                end = content_.size();
+            }
+
+            line = content_.substr(position_, end - position_);
+            position_ = end + 1;
+            ++line_number_;
+
+            if(!line.empty() && line.back() == '\r'){
+                line.remove_suffix(1);
+            }
+
+            if(line.find_first_not_of(" \t") != std::string_view::npos){
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+}//namespace input_signals
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include "InputFileWatcher.h"
+
+namespace input_signals{
+
+    //Последовательное чтение записанного потока входных сигналов в формате JSON Lines:
+    //одна строка - объект {"KKS": значение, ...} на один шаг расчёта.
+    //Строка может содержать все KKS (снимок) или только изменившиеся (приращение).
+    class ReplayReader{
+    public:
+        [[nodiscard]] bool Open(const std::filesystem::path& path);
+        void Close();
+
+        //Следующая непустая строка. Действительна до Close.
+        [[nodiscard]] bool NextLine(std::string_view& line);
+
+        //Номер строки файла, возвращённой последним NextLine, с 1
+        size_t GetLineNumber() const{
+            return line_number_;
+        }
+
+    private:
+        MappedFile file_;
+        std::string_view content_;
+        size_t position_ = 0;
+        size_t line_number_ = 0;
+    };
+
+}//namespace input_signals
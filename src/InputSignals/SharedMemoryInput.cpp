@@ -0,0 +1,175 @@
+#include "SharedMemoryInput.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace input_signals{
+
+    using namespace shared_memory;
+
+    SharedMemoryInput::~SharedMemoryInput(){
+        Detach();
+    }
+
+    void SharedMemoryInput::SetName(std::string name){
+        Detach();
+        name_ = std::move(name);
+    }
+
+    void SharedMemoryInput::ResetMapping(){
+        mapped_ = false;
+        has_snapshot_ = false;
+    }
+
+    #ifdef _WIN32
+
+    bool SharedMemoryInput::Attach(){
+        return false;
+    }
+
+    void SharedMemoryInput::Detach(){
+        header_ = nullptr;
+        size_segment_ = 0;
+        ResetMapping();
+    }
+
+    #else
+
+    bool SharedMemoryInput::Attach(){
+        Detach();
+
+        int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+        if(fd == -1){
+            return false;
+        }
+
+        struct stat stat_segment;
+        if(::fstat(fd, &stat_segment) == -1 || static_cast<size_t>(stat_segment.st_size) < sizeof(Header)){
+            ::close(fd);
+            return false;
+        }
+
+        size_t size_segment = static_cast<size_t>(stat_segment.st_size);
+        void* view = ::mmap(nullptr, size_segment, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if(view == MAP_FAILED){
+            return false;
+        }
+
+        auto* header = static_cast<Header*>(view);
+
+        if(header->magic != kMagic || header->version != kVersion || header->size_slot != sizeof(Slot)
+            || GetSizeSegment(header->count_slots) > size_segment){
+            ::munmap(view, size_segment);
+            return false;
+        }
+
+        header_ = header;
+        size_segment_ = size_segment;
+        id_layout_ = header->id_layout;
+
+        return true;
+    }
+
+    void SharedMemoryInput::Detach(){
+        if(header_ != nullptr){
+            ::munmap(header_, size_segment_);
+        }
+
+        header_ = nullptr;
+        size_segment_ = 0;
+        ResetMapping();
+    }
+
+    #endif
+
+    void SharedMemoryInput::MapSlots(const KKSSlotTable& table){
+        segment_to_table_slot_.clear();
+
+        const Slot* slots = GetSlots(header_);
+        for(uint32_t i = 0; i < header_->count_slots; ++i){
+            std::string_view kks(slots[i].kks, ::strnlen(slots[i].kks, kSizeKKS));
+
+            if(int slot_table = table.FindSlot(kks); slot_table != KKSSlotTable::kNotFound){
+                segment_to_table_slot_.emplace_back(i, slot_table);
+            }
+        }
+
+        mapped_ = true;
+        has_snapshot_ = false;
+    }
+
+    SharedMemoryInput::StateRead SharedMemoryInput::ReadSnapshot(KKSSlotTable& table, int max_attempts){
+
+        //Поставщик мог пересоздать сегмент с другим набором KKS
+        if(header_ != nullptr && (header_->magic != kMagic || header_->id_layout != id_layout_)){
+            Detach();
+        }
+
+        if(header_ == nullptr && !Attach()){
+            return StateRead::kError;
+        }
+
+        if(!mapped_){
+            MapSlots(table);
+        }
+
+        const Slot* slots = GetSlots(header_);
+
+        for(int attempt = 0; attempt < max_attempts; ++attempt){
+            uint64_t sequence_begin = header_->sequence.load(std::memory_order_acquire);
+
+            if(sequence_begin & 1){
+                std::this_thread::yield();
+                continue;
+            }
+
+            if(has_snapshot_ && sequence_begin == last_sequence_){
+                return StateRead::kUnchanged;
+            }
+
+            table.BeginUpdate();
+
+            for(const auto& [slot_segment, slot_table] : segment_to_table_slot_){
+                const Slot& slot = slots[slot_segment];
+
+                switch(slot.type_value){
+                    case TypeValue::kInt:
+                        table.SetValue(slot_table, static_cast<int>(slot.value_int));
+                        break;
+                    case TypeValue::kDouble:
+                        table.SetValue(slot_table, slot.value_double);
+                        break;
+                    case TypeValue::kString:
+                        table.SetValue(slot_table, std::string_view(slot.value_string, std::min<size_t>(slot.size_string, kSizeString)));
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if(header_->sequence.load(std::memory_order_relaxed) == sequence_begin){
+                last_sequence_ = sequence_begin;
+                has_snapshot_ = true;
+                return StateRead::kUpdated;
+            }
+
+            table.DiscardUpdate();
+        }
+
+        return StateRead::kError;
+    }
+
+}//namespace input_signals
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "KKSSlotTable.h"
+#include "SharedMemoryLayout.h"
+
+namespace input_signals{
+
+    //Чтение входных сигналов из сегмента разделяемой памяти (см. SharedMemoryLayout.h).
+    class SharedMemoryInput{
+    public:
+        enum class StateRead{
+            kUpdated,       //Снимок прочитан в KKSSlotTable, нужен CommitUpdate
+            kUnchanged,     //Поставщик ничего не записал с прошлого чтения
+            kError
+        };
+
+        SharedMemoryInput() = default;
+        ~SharedMemoryInput();
+
+        SharedMemoryInput(const SharedMemoryInput& other) = delete;
+        SharedMemoryInput& operator=(const SharedMemoryInput& other) = delete;
+
+        void SetName(std::string name);
+        const std::string& GetName() const{
+            return name_;
+        }
+
+        void Detach();
+
+        //Сопоставление слотов сегмента и KKSSlotTable пересчитывается при смене таблицы или сегмента
+        void ResetMapping();
+
+        [[nodiscard]] StateRead ReadSnapshot(KKSSlotTable& table, int max_attempts = 1000);
+
+    private:
+        [[nodiscard]] bool Attach();
+        void MapSlots(const KKSSlotTable& table);
+
+        std::string name_;
+
+        shared_memory::Header* header_ = nullptr;
+        size_t size_segment_ = 0;
+
+        uint64_t id_layout_ = 0;
+        uint64_t last_sequence_ = 0;
+        bool has_snapshot_ = false;
+        bool mapped_ = false;
+
+        //Пары (слот сегмента, слот KKSSlotTable)
+        std::vector<std::pair<uint32_t, int>> segment_to_table_slot_;
+    };
+
+}//namespace input_signals
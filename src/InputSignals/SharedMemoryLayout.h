@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//Общий для поставщика данных и CalcServer формат сегмента разделяемой памяти с входными сигналами.
+//
+//  [Header][Slot 0][Slot 1]...[Slot count_slots - 1]
+//
+//Набор KKS задаётся поставщиком при создании сегмента и дальше не меняется. Чтобы сменить набор,
+//поставщик обнуляет magic старого сегмента, удаляет его имя и создаёт новый сегмент с тем же именем.
+//Значения пишутся на месте под seqlock: sequence нечётный, пока поставщик пишет,
+//читатель повторяет чтение, если sequence изменился за время копирования.
+
+namespace input_signals::shared_memory{
+
+    constexpr uint32_t kMagic = 0x4D534343; //"CCSM"
+    constexpr uint32_t kVersion = 1;
+
+    constexpr size_t kSizeKKS = 64;
+    constexpr size_t kSizeString = 64;
+
+    enum class TypeValue : uint32_t{
+        kNone = 0,
+        kInt = 1,
+        kDouble = 2,
+        kString = 3
+    };
+
+    struct alignas(64) Header{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count_slots;
+        uint32_t size_slot;
+        //Меняется при каждом пересоздании сегмента, читатель по нему заново сопоставляет KKS
+        uint64_t id_layout;
+        std::atomic<uint64_t> sequence;
+    };
+
+    struct Slot{
+        char kks[kSizeKKS];
+        TypeValue type_value;
+        uint32_t size_string;
+        int64_t value_int;
+        double value_double;
+        char value_string[kSizeString];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The seqlock requires a lock-free 64-bit atomic");
+
+    constexpr size_t GetSizeSegment(uint32_t count_slots){
+        return sizeof(Header) + static_cast<size_t>(count_slots) * sizeof(Slot);
+    }
+
+    inline Slot* GetSlots(Header* header){
+        return reinterpret_cast<Slot*>(reinterpret_cast<std::byte*>(header) + sizeof(Header));
+    }
+
+    inline const Slot* GetSlots(const Header* header){
+        return reinterpret_cast<const Slot*>(reinterpret_cast<const std::byte*>(header) + sizeof(Header));
+    }
+
+}//namespace input_signals::shared_memory
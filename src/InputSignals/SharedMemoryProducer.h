@@ -0,0 +1,194 @@
+#pragma once
+
+//Заголовочный файл для поставщика данных: создаёт сегмент разделяемой памяти и пишет в него значения KKS.
+//Не зависит от CalcServer, достаточно скопировать вместе с SharedMemoryLayout.h.
+//
+//  SharedMemoryProducer producer;
+//  producer.Create("/calc_server_input", {"KKS_001", "KKS_002"});
+//  producer.BeginWrite();
+//  producer.SetValue(0, 1.5);
+//  producer.SetValue(1, 3);
+//  producer.EndWrite();
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SharedMemoryLayout.h"
+
+namespace input_signals::shared_memory{
+
+    class SharedMemoryProducer{
+    public:
+        SharedMemoryProducer() = default;
+
+        ~SharedMemoryProducer(){
+            Close();
+        }
+
+        SharedMemoryProducer(const SharedMemoryProducer& other) = delete;
+        SharedMemoryProducer& operator=(const SharedMemoryProducer& other) = delete;
+
+        [[nodiscard]] bool Create(const std::string& name, const std::vector<std::string>& list_kks){
+            Close();
+
+            for(const auto& kks : list_kks){
+                if(kks.empty() || kks.size() >= kSizeKKS){
+                    return false;
+                }
+            }
+
+            //Существующий сегмент не переиспользуется: ftruncate уменьшил бы его под читателем (SIGBUS),
+            //а сброс sequence сломал бы seqlock для читателя посреди копирования
+            RetireSegment(name);
+
+            int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+            if(fd == -1){
+                return false;
+            }
+
+            size_t size_segment = GetSizeSegment(static_cast<uint32_t>(list_kks.size()));
+
+            if(::ftruncate(fd, static_cast<off_t>(size_segment)) == -1){
+                ::close(fd);
+                ::shm_unlink(name.c_str());
+                return false;
+            }
+
+            void* view = ::mmap(nullptr, size_segment, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+
+            if(view == MAP_FAILED){
+                ::shm_unlink(name.c_str());
+                return false;
+            }
+
+            name_ = name;
+            size_segment_ = size_segment;
+            header_ = static_cast<Header*>(view);
+
+            //Новый сегмент заполнен нулями: пока magic не записан, читатель считает его неготовым
+            header_->version = kVersion;
+            header_->count_slots = static_cast<uint32_t>(list_kks.size());
+            header_->size_slot = sizeof(Slot);
+            header_->id_layout = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            new (&header_->sequence) std::atomic<uint64_t>(0);
+
+            Slot* slots = GetSlots(header_);
+            for(size_t i = 0; i < list_kks.size(); ++i){
+                std::memset(&slots[i], 0, sizeof(Slot));
+                std::memcpy(slots[i].kks, list_kks[i].data(), list_kks[i].size());
+            }
+
+            std::atomic_thread_fence(std::memory_order_release);
+            header_->magic = kMagic;
+
+            return true;
+        }
+
+        void Close(bool unlink = false){
+            if(header_ != nullptr){
+                ::munmap(header_, size_segment_);
+                if(unlink){
+                    ::shm_unlink(name_.c_str());
+                }
+            }
+
+            header_ = nullptr;
+            size_segment_ = 0;
+        }
+
+        int FindSlot(std::string_view kks) const{
+            if(header_ == nullptr){
+                return -1;
+            }
+
+            const Slot* slots = GetSlots(header_);
+            for(uint32_t i = 0; i < header_->count_slots; ++i){
+                if(kks == std::string_view(slots[i].kks, ::strnlen(slots[i].kks, kSizeKKS))){
+                    return static_cast<int>(i);
+                }
+            }
+
+            return -1;
+        }
+
+        uint32_t GetCountSlots() const{
+            return (header_ == nullptr) ? 0 : header_->count_slots;
+        }
+
+        //Все SetValue между BeginWrite и EndWrite читатель увидит одним снимком
+        void BeginWrite(){
+            header_->sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void EndWrite(){
+            header_->sequence.fetch_add(1, std::memory_order_release);
+        }
+
+        void SetValue(int slot, int64_t value){
+            Slot& target = GetSlots(header_)[slot];
+            target.value_int = value;
+            target.type_value = TypeValue::kInt;
+        }
+
+        void SetValue(int slot, int value){
+            SetValue(slot, static_cast<int64_t>(value));
+        }
+
+        void SetValue(int slot, double value){
+            Slot& target = GetSlots(header_)[slot];
+            target.value_double = value;
+            target.type_value = TypeValue::kDouble;
+        }
+
+        void SetValue(int slot, std::string_view value){
+            Slot& target = GetSlots(header_)[slot];
+            size_t size_value = std::min(value.size(), kSizeString);
+            std::memcpy(target.value_string, value.data(), size_value);
+            target.size_string = static_cast<uint32_t>(size_value);
+            target.type_value = TypeValue::kString;
+        }
+
+    private:
+        //Помечает сегмент снятым (magic = 0) и удаляет имя. Читатели, которые его отобразили,
+        //дочитывают старый сегмент без изменения размера и по magic переподключаются к новому.
+        static void RetireSegment(const std::string& name){
+            int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+            if(fd == -1){
+                return;
+            }
+
+            struct stat stat_segment;
+            if(::fstat(fd, &stat_segment) == 0 && static_cast<size_t>(stat_segment.st_size) >= sizeof(Header)){
+                void* view = ::mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if(view != MAP_FAILED){
+                    static_cast<Header*>(view)->magic = 0;
+                    ::munmap(view, sizeof(Header));
+                }
+            }
+
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+        }
+
+        std::string name_;
+        size_t size_segment_ = 0;
+        Header* header_ = nullptr;
+    };
+
+}//namespace input_signals::shared_memory
+
+#endif
@@ -0,0 +1,241 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <map>
+
+namespace metrics{
+
+    void LatencyHistogram::Record(std::chrono::nanoseconds duration){
+        int64_t ns = std::max<int64_t>(duration.count(), 0);
+        double us = static_cast<double>(ns) / 1000.0;
+
+        size_t index = std::lower_bound(kBounds.begin(), kBounds.end(), us) - kBounds.begin();
+
+        buckets_[index].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double LatencyHistogram::GetSum() const{
+        return static_cast<double>(sum_ns_.load(std::memory_order_relaxed)) / 1e9;
+    }
+
+    double LatencyHistogram::GetQuantile(double quantile) const{
+        uint64_t total = 0;
+        for(const auto& bucket : buckets_){
+            total += bucket.load(std::memory_order_relaxed);
+        }
+
+        if(total == 0){
+            return 0.0;
+        }
+
+        uint64_t target = static_cast<uint64_t>(quantile * static_cast<double>(total));
+        uint64_t accumulated = 0;
+
+        for(size_t index = 0; index < kBounds.size(); ++index){
+            accumulated += buckets_[index].load(std::memory_order_relaxed);
+            if(accumulated > target){
+                return kBounds[index] / 1e6;
+            }
+        }
+
+        return kBounds.back() / 1e6;
+    }
+
+    void LatencyHistogram::Reset(){
+        for(auto& bucket : buckets_){
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_ns_.store(0, std::memory_order_relaxed);
+    }
+
+    MetricsRegistry::~MetricsRegistry(){
+        StopExport();
+    }
+
+    std::string MetricsRegistry::MakeKey(const std::string& name, const Labels& labels){
+        std::string key = name;
+        for(const auto& [label, value] : labels){
+            key += '\0';
+            key += label;
+            key += '\0';
+            key += value;
+        }
+        return key;
+    }
+
+    LatencyHistogram& MetricsRegistry::GetHistogram(const std::string& name, const std::string& help, Labels labels){
+        std::lock_guard lock(mutex_);
+
+        Entry*& indexed = index_entries_[MakeKey(name, labels)];
+        if(indexed != nullptr){
+            return indexed->histogram;
+        }
+
+        auto& entry = entries_.emplace_back(std::make_unique<Entry>());
+        entry->name = name;
+        entry->help = help;
+        entry->labels = std::move(labels);
+        indexed = entry.get();
+
+        return entry->histogram;
+    }
+
+    const LatencyHistogram* MetricsRegistry::FindHistogram(const std::string& name, const Labels& labels) const{
+        std::lock_guard lock(mutex_);
+
+        if(auto entry = index_entries_.find(MakeKey(name, labels)); entry != index_entries_.end()){
+            return &entry->second->histogram;
+        }
+
+        return nullptr;
+    }
+
+    void MetricsRegistry::Reset(){
+        std::lock_guard lock(mutex_);
+
+        for(auto& entry : entries_){
+            entry->histogram.Reset();
+        }
+    }
+
+    void MetricsRegistry::Remove(const std::string& name, const std::unordered_set<const LatencyHistogram*>& kept){
+        std::lock_guard lock(mutex_);
+
+        auto is_removed = [&name, &kept](const Entry& entry){
+            return entry.name == name && !kept.contains(&entry.histogram);
+        };
+
+        std::erase_if(index_entries_, [&is_removed](const auto& entry){ return is_removed(*entry.second); });
+        std::erase_if(entries_, [&is_removed](const auto& entry){ return is_removed(*entry); });
+    }
+
+    namespace{
+
+        std::string EscapeLabel(const std::string& value){
+            std::string escaped;
+            escaped.reserve(value.size());
+
+            for(char symbol : value){
+                if(symbol == '\\' || symbol == '"'){
+                    escaped += '\\';
+                    escaped += symbol;
+                }else if(symbol == '\n'){
+                    escaped += "\\n";
+                }else{
+                    escaped += symbol;
+                }
+            }
+
+            return escaped;
+        }
+
+        std::string FormatLabels(const Labels& labels, const std::string& le = ""){
+            std::string result;
+
+            for(const auto& [name, value] : labels){
+                result += (result.empty()) ? "{" : ",";
+                result += name + "=\"" + EscapeLabel(value) + "\"";
+            }
+
+            if(!le.empty()){
+                result += (result.empty()) ? "{" : ",";
+                result += "le=\"" + le + "\"";
+            }
+
+            return (result.empty()) ? result : result + "}";
+        }
+
+    }
+
+    void MetricsRegistry::WritePrometheus(std::ostream& out) const{
+        std::lock_guard lock(mutex_);
+
+        //Сумма в секундах без потери точности (по умолчанию поток выводит 6 значащих цифр)
+        auto precision = out.precision(std::numeric_limits<double>::max_digits10);
+
+        //Строки HELP и TYPE выводятся один раз на имя
+        std::map<std::string, std::vector<const Entry*>> name_to_entries;
+        for(const auto& entry : entries_){
+            name_to_entries[entry->name].push_back(entry.get());
+        }
+
+        for(const auto& [name, entries] : name_to_entries){
+            out << "# HELP " << name << " " << entries.front()->help << "\n";
+            out << "# TYPE " << name << " histogram\n";
+
+            for(const Entry* entry : entries){
+                const LatencyHistogram& histogram = entry->histogram;
+                uint64_t accumulated = 0;
+
+                for(size_t index = 0; index < LatencyHistogram::kBounds.size(); ++index){
+                    accumulated += histogram.GetBucket(index);
+                    out << name << "_bucket" << FormatLabels(entry->labels, std::to_string(LatencyHistogram::kBounds[index] / 1e6)) << " " << accumulated << "\n";
+                }
+
+                accumulated += histogram.GetBucket(LatencyHistogram::kBounds.size());
+                out << name << "_bucket" << FormatLabels(entry->labels, "+Inf") << " " << accumulated << "\n";
+                out << name << "_sum" << FormatLabels(entry->labels) << " " << histogram.GetSum() << "\n";
+                out << name << "_count" << FormatLabels(entry->labels) << " " << accumulated << "\n";
+            }
+        }
+
+        out.precision(precision);
+    }
+
+    bool MetricsRegistry::WritePrometheusFile(const std::filesystem::path& path) const{
+        std::filesystem::path path_temp = path;
+        path_temp += ".tmp";
+
+        {
+            std::ofstream file(path_temp, std::ios::trunc);
+            if(!file.is_open()){
+                return false;
+            }
+
+            WritePrometheus(file);
+
+            if(!file.good()){
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(path_temp, path, error);
+
+        return !error;
+    }
+
+    void MetricsRegistry::StartExport(std::filesystem::path path, std::chrono::milliseconds interval){
+        StopExport();
+
+        stop_export_ = false;
+        export_thread_ = std::thread([this, path = std::move(path), interval](){
+            std::unique_lock lock(mutex_export_);
+
+            while(!cv_export_.wait_for(lock, interval, [this](){ return stop_export_; })){
+                (void)WritePrometheusFile(path);
+            }
+
+            (void)WritePrometheusFile(path);
+        });
+    }
+
+    void MetricsRegistry::StopExport(){
+        if(!export_thread_.joinable()){
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex_export_);
+            stop_export_ = true;
+        }
+        cv_export_.notify_all();
+        export_thread_.join();
+    }
+
+}//namespace metrics
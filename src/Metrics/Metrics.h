@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace metrics{
+
+    //Гистограмма длительностей с фиксированными границами корзин, запись без блокировок
+    class LatencyHistogram{
+    public:
+        //Верхние границы корзин в микросекундах, последняя корзина - +Inf
+        static constexpr std::array<double, 20> kBounds = {
+            1, 2, 5, 10, 20, 50, 100, 200, 500, 1000,
+            2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 5000000
+        };
+
+        void Record(std::chrono::nanoseconds duration);
+
+        uint64_t GetCount() const{
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        //Сумма в секундах
+        double GetSum() const;
+
+        //Оценка квантиля по корзинам (верхняя граница корзины), в секундах
+        double GetQuantile(double quantile) const;
+
+        uint64_t GetBucket(size_t index) const{
+            return buckets_[index].load(std::memory_order_relaxed);
+        }
+
+        void Reset();
+
+    private:
+        std::array<std::atomic<uint64_t>, kBounds.size() + 1> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_ns_{0};
+    };
+
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    //Набор гистограмм с именами и метками. Гистограммы создаются при подготовке расчёта,
+    //запись идёт без обращения к реестру. GetHistogram с теми же именем и метками возвращает существующую гистограмму.
+    //Ссылка действительна до удаления гистограммы вызовом Remove (гистограммы из kept не удаляются) или до разрушения реестра.
+    class MetricsRegistry{
+    public:
+        MetricsRegistry() = default;
+        ~MetricsRegistry();
+
+        MetricsRegistry(const MetricsRegistry& other) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry& other) = delete;
+
+        LatencyHistogram& GetHistogram(const std::string& name, const std::string& help, Labels labels = {});
+
+        const LatencyHistogram* FindHistogram(const std::string& name, const Labels& labels = {}) const;
+
+        //Обнуляет все гистограммы, например, после прогрева
+        void Reset();
+
+        //Удаляет гистограммы с именем name, кроме kept (например, блоки расчёта, которых нет в новом наборе).
+        //Ссылки на оставшиеся гистограммы действительны, накопленные значения сохраняются
+        void Remove(const std::string& name, const std::unordered_set<const LatencyHistogram*>& kept = {});
+
+        //Текстовый формат Prometheus (exposition format 0.0.4)
+        void WritePrometheus(std::ostream& out) const;
+
+        //Запись во временный файл и переименование, чтобы сборщик не прочитал файл наполовину
+        [[nodiscard]] bool WritePrometheusFile(const std::filesystem::path& path) const;
+
+        //Фоновая запись файла каждые interval
+        void StartExport(std::filesystem::path path, std::chrono::milliseconds interval);
+        void StopExport();
+
+    private:
+        struct Entry{
+            std::string name;
+            std::string help;
+            Labels labels;
+            LatencyHistogram histogram;
+        };
+
+        //Имя и метки в одной строке для поиска в index_entries_
+        static std::string MakeKey(const std::string& name, const Labels& labels);
+
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<Entry>> entries_;
+        std::unordered_map<std::string, Entry*> index_entries_;
+
+        std::thread export_thread_;
+        std::mutex mutex_export_;
+        std::condition_variable cv_export_;
+        bool stop_export_ = false;
+    };
+
+    //Замер времени области видимости. При histogram == nullptr ничего не измеряет.
+    class ScopedTimer{
+    public:
+        explicit ScopedTimer(LatencyHistogram* histogram)
+            :   histogram_(histogram),
+                start_((histogram != nullptr) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{})
+        {}
+
+        ~ScopedTimer(){
+            if(histogram_ != nullptr){
+                histogram_->Record(std::chrono::steady_clock::now() - start_);
+            }
+        }
+
+        ScopedTimer(const ScopedTimer& other) = delete;
+        ScopedTimer& operator=(const ScopedTimer& other) = delete;
+
+    private:
+        LatencyHistogram* histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+}//namespace metrics
@@ -0,0 +1,129 @@
+#include "ModelSnapshot.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "InputFileWatcher.h"
+
+namespace model_snapshot{
+
+    bool ReadSnapshot(const std::filesystem::path& path, nlohmann::json& document, std::string& error){
+        input_signals::MappedFile file;
+
+        if(!file.Open(path)){
+            error = "the file was not found";
+            return false;
+        }
+
+        std::string_view content = file.GetContent();
+        Header header;
+
+        if(content.size() < sizeof(header)){
+            error = "the file is too small";
+            return false;
+        }
+
+        std::memcpy(&header, content.data(), sizeof(header));
+
+        if(std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0){
+            error = "the file is not a model snapshot";
+            return false;
+        }
+
+        if(header.version != kFormatVersion){
+            error = "the snapshot format version " + std::to_string(header.version) + " is not supported";
+            return false;
+        }
+
+        if(header.size_document != content.size() - sizeof(header)){
+            error = "the file is truncated";
+            return false;
+        }
+
+        try{
+            const char* begin = content.data() + sizeof(header);
+            document = nlohmann::json::from_msgpack(begin, begin + header.size_document);
+        }catch(const std::exception& e){
+            error = e.what();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool WriteSnapshot(const std::filesystem::path& path, const nlohmann::json& document){
+        std::vector<std::uint8_t> content = nlohmann::json::to_msgpack(document);
+
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kFormatVersion;
+        header.size_document = content.size();
+
+        std::filesystem::path path_temp = path;
+        path_temp += ".tmp";
+
+        {
+            std::ofstream file(path_temp, std::ios::binary | std::ios::trunc);
+            if(!file.is_open()){
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+
+            if(!file.good()){
+                return false;
+            }
+        }
+
+        std::error_code code_error;
+        std::filesystem::rename(path_temp, path, code_error);
+
+        return !code_error;
+    }
+
+    void KeyHasher::Add(std::string_view value){
+        Add(static_cast<uint64_t>(value.size()));
+        Add(input_signals::HashContent(value));
+    }
+
+    void KeyHasher::Add(uint64_t value){
+        //FNV-1a по байтам значения
+        for(int byte = 0; byte < 8; ++byte){
+            hash_ ^= (value >> (byte * 8)) & 0xFF;
+            hash_ *= 1099511628211ull;
+        }
+    }
+
+    bool KeyHasher::AddFileContent(const std::filesystem::path& path){
+        input_signals::MappedFile file;
+
+        if(!file.Open(path)){
+            return false;
+        }
+
+        Add(file.GetContent());
+        return true;
+    }
+
+    bool KeyHasher::AddFileStamp(const std::filesystem::path& path){
+        std::error_code code_error;
+
+        auto size_file = std::filesystem::file_size(path, code_error);
+        if(code_error){
+            return false;
+        }
+
+        auto write_time = std::filesystem::last_write_time(path, code_error);
+        if(code_error){
+            return false;
+        }
+
+        Add(path.filename().string());
+        Add(static_cast<uint64_t>(size_file));
+        Add(static_cast<uint64_t>(write_time.time_since_epoch().count()));
+        return true;
+    }
+
+}//namespace model_snapshot
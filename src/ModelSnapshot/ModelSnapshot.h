@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+namespace model_snapshot{
+
+    //Файл снимка: заголовок и документ в формате MessagePack.
+    //При изменении содержимого документа увеличивается kFormatVersion, старые снимки отбрасываются.
+    static constexpr char kMagic[8] = {'C', 'S', 'M', 'O', 'D', 'E', 'L', '\0'};
+    static constexpr uint32_t kFormatVersion = 1;
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t size_document;
+    };
+
+    //false - файла нет или он не подходит, причина в error
+    [[nodiscard]] bool ReadSnapshot(const std::filesystem::path& path, nlohmann::json& document, std::string& error);
+
+    //Запись во временный файл с последующей заменой, чтобы прерванная запись не оставила испорченный снимок
+    [[nodiscard]] bool WriteSnapshot(const std::filesystem::path& path, const nlohmann::json& document);
+
+    //Ключ совпадения снимка с исходными данными
+    class KeyHasher{
+    public:
+        void Add(std::string_view value);
+        void Add(uint64_t value);
+
+        //Содержимое файла
+        [[nodiscard]] bool AddFileContent(const std::filesystem::path& path);
+
+        //Размер и время изменения файла, без чтения (для DLL)
+        [[nodiscard]] bool AddFileStamp(const std::filesystem::path& path);
+
+        uint64_t Get() const{
+            return hash_;
+        }
+
+    private:
+        uint64_t hash_ = 14695981039346656037ull;
+    };
+
+}//namespace model_snapshot
@@ -0,0 +1,185 @@
+#include "OutputBatcher.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace output_writer{
+
+    void OutputBatcher::SetBatch(size_t max_steps, std::chrono::milliseconds flush_interval){
+        max_steps_ = std::max<size_t>(max_steps, 1);
+        flush_interval_ = flush_interval;
+    }
+
+    int OutputBatcher::RegisterTable(const std::string& table_name, std::string insert_head, size_t count_columns, std::vector<std::string> placeholders){
+        if(auto iter_table = name_to_table_.find(table_name); iter_table != name_to_table_.end()){
+            Table& table = tables_[iter_table->second];
+            if(table.insert_head != insert_head || table.count_columns != count_columns || table.placeholders != placeholders){
+                table.insert_head = std::move(insert_head);
+                table.count_columns = count_columns;
+                table.placeholders = std::move(placeholders);
+                table.request_single_row.clear();
+                table.request_max_rows.clear();
+                count_pending_rows_ -= table.count_rows;
+                table.count_rows = 0;
+                table.values.clear();
+            }
+            return iter_table->second;
+        }
+
+        Table& table = tables_.emplace_back();
+        table.name = table_name;
+        table.insert_head = std::move(insert_head);
+        table.count_columns = count_columns;
+        table.placeholders = std::move(placeholders);
+
+        int index_table = static_cast<int>(tables_.size() - 1);
+        name_to_table_[table_name] = index_table;
+
+        return index_table;
+    }
+
+    int OutputBatcher::FindTable(const std::string& table_name) const{
+        auto iter_table = name_to_table_.find(table_name);
+        return (iter_table == name_to_table_.end()) ? -1 : iter_table->second;
+    }
+
+    void OutputBatcher::Clear(){
+        tables_.clear();
+        name_to_table_.clear();
+        count_pending_rows_ = 0;
+        count_steps_ = 0;
+    }
+
+    size_t OutputBatcher::GetMaxRows(const Table& table){
+        return std::max<size_t>(kMaxParameters / std::max<size_t>(table.count_columns, 1), 1);
+    }
+
+    void OutputBatcher::BuildInsertRequest(const Table& table, size_t count_rows, std::string& request){
+        request.clear();
+        request += table.insert_head;
+        request += " VALUES ";
+
+        size_t num_place = 1;
+        for(size_t row = 0; row < count_rows; ++row){
+            request += (row == 0) ? "(" : ", (";
+            for(size_t column = 0; column < table.count_columns; ++column){
+                if(column != 0){
+                    request += ", ";
+                }
+
+                std::string place = "$" + std::to_string(num_place++);
+
+                size_t position_place = std::string::npos;
+                if(column < table.placeholders.size()){
+                    position_place = table.placeholders[column].find("{}");
+                }
+
+                if(position_place == std::string::npos){
+                    request += place;
+                }else{
+                    request.append(table.placeholders[column], 0, position_place);
+                    request += place;
+                    request.append(table.placeholders[column], position_place + 2);
+                }
+            }
+            request += ")";
+        }
+    }
+
+    const std::string& OutputBatcher::GetInsertRequest(int index_table, size_t count_rows){
+        Table& table = tables_[index_table];
+
+        //Число строк остальных запросов зависит от интервала сброса и записи изменений, такие запросы
+        //не запоминаются: на широкой таблице каждый занимал бы O(строк * столбцов)
+        std::string* request = &table.request_buffer;
+        if(count_rows == 1){
+            request = &table.request_single_row;
+        }else if(count_rows == GetMaxRows(table)){
+            request = &table.request_max_rows;
+        }
+
+        if(request == &table.request_buffer || request->empty()){
+            BuildInsertRequest(table, count_rows, *request);
+        }
+
+        return *request;
+    }
+
+    void OutputBatcher::AddRow(int index_table, std::vector<std::string>&& values){
+        Table& table = tables_[index_table];
+
+        if(table.values.empty()){
+            table.values = std::move(values);
+        }else{
+            table.values.insert(table.values.end(), std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+        }
+
+        ++table.count_rows;
+        ++count_pending_rows_;
+    }
+
+    bool OutputBatcher::EndStep(){
+        ++count_steps_;
+
+        if(count_pending_rows_ == 0){
+            return false;
+        }
+
+        if(hold_){
+            for(const Table& table : tables_){
+                if(table.count_rows * table.count_columns >= kMaxParameters){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if(count_steps_ >= max_steps_){
+            return true;
+        }
+
+        return flush_interval_.count() > 0 && std::chrono::steady_clock::now() - last_flush_ >= flush_interval_;
+    }
+
+    bool OutputBatcher::IsFlushIntervalExpired() const{
+        return !hold_ && count_pending_rows_ != 0 && flush_interval_.count() > 0 && std::chrono::steady_clock::now() - last_flush_ >= flush_interval_;
+    }
+
+    bool OutputBatcher::Flush(const SendRequest& send_request){
+        bool result = true;
+
+        for(int index_table = 0; index_table < static_cast<int>(tables_.size()); ++index_table){
+            Table& table = tables_[index_table];
+
+            if(table.count_rows == 0){
+                continue;
+            }
+
+            size_t max_rows = GetMaxRows(table);
+
+            if(table.count_rows <= max_rows){
+                result &= send_request(table.name, GetInsertRequest(index_table, table.count_rows), std::move(table.values));
+            }else{
+                for(size_t first_row = 0; first_row < table.count_rows; first_row += max_rows){
+                    size_t count_rows = std::min(max_rows, table.count_rows - first_row);
+
+                    auto begin_values = table.values.begin() + first_row * table.count_columns;
+                    std::vector<std::string> values(std::make_move_iterator(begin_values),
+                                                    std::make_move_iterator(begin_values + count_rows * table.count_columns));
+
+                    result &= send_request(table.name, GetInsertRequest(index_table, count_rows), std::move(values));
+                }
+            }
+
+            table.values.clear();
+            table.count_rows = 0;
+        }
+
+        count_pending_rows_ = 0;
+        count_steps_ = 0;
+        last_flush_ = std::chrono::steady_clock::now();
+
+        return result;
+    }
+
+}//namespace output_writer
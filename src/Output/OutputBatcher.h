@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace output_writer{
+
+    //Накопление строк выходных таблиц за несколько шагов и запись их одним многострочным INSERT на таблицу.
+    class OutputBatcher{
+    public:
+        //Запрос на запись: имя таблицы, текст запроса, параметры всех строк подряд
+        using SendRequest = std::function<bool(const std::string& table_name, const std::string& query, std::vector<std::string>&& values)>;
+
+        //Ограничение PostgreSQL на число параметров в одном запросе
+        static constexpr size_t kMaxParameters = 65535;
+
+        void SetBatch(size_t max_steps, std::chrono::milliseconds flush_interval);
+
+        //Пока включено, max_steps и flush_interval не действуют: строки копятся, пока у какой-либо таблицы
+        //не наберётся полный запрос (kMaxParameters параметров)
+        void SetHold(bool hold){
+            hold_ = hold;
+        }
+
+        //insert_head - "INSERT INTO table (col_1, ..., col_n)"
+        //placeholders - выражение для параметра столбца, "{}" заменяется на $N, например "to_timestamp({})".
+        //Для пустого или отсутствующего выражения подставляется просто $N.
+        int RegisterTable(const std::string& table_name, std::string insert_head, size_t count_columns, std::vector<std::string> placeholders = {});
+        int FindTable(const std::string& table_name) const;
+        void Clear();
+
+        //Текст запроса на запись count_rows строк. Запросы на одну строку и на полный запрос (kMaxParameters
+        //параметров) хранятся, остальные собираются в общий буфер таблицы: ссылка действительна до следующего
+        //вызова для той же таблицы
+        const std::string& GetInsertRequest(int table, size_t count_rows);
+
+        void AddRow(int table, std::vector<std::string>&& values);
+
+        //Отмечает конец шага, возвращает true, если пора сбрасывать накопленные строки
+        [[nodiscard]] bool EndStep();
+
+        //Истёк ли интервал сброса при наличии накопленных строк
+        bool IsFlushIntervalExpired() const;
+
+        bool Empty() const{
+            return count_pending_rows_ == 0;
+        }
+
+        [[nodiscard]] bool Flush(const SendRequest& send_request);
+
+    private:
+        struct Table{
+            std::string name;
+            std::string insert_head;
+            size_t count_columns = 0;
+            std::vector<std::string> placeholders;
+
+            size_t count_rows = 0;
+            std::vector<std::string> values;
+
+            std::string request_single_row;
+            std::string request_max_rows;
+            std::string request_buffer;
+        };
+
+        //Наибольшее число строк в одном запросе
+        static size_t GetMaxRows(const Table& table);
+        static void BuildInsertRequest(const Table& table, size_t count_rows, std::string& request);
+
+        std::vector<Table> tables_;
+        std::unordered_map<std::string, int> name_to_table_;
+
+        size_t max_steps_ = 1;
+        std::chrono::milliseconds flush_interval_{0};
+
+        bool hold_ = false;
+
+        size_t count_steps_ = 0;
+        size_t count_pending_rows_ = 0;
+        std::chrono::steady_clock::time_point last_flush_ = std::chrono::steady_clock::now();
+    };
+
+}//namespace output_writer
@@ -0,0 +1,69 @@
+#include "OutputPipeline.h"
+
+#include <bit>
+#include <cstdint>
+
+namespace output_writer{
+
+    BoundedIndexQueue::BoundedIndexQueue(size_t capacity){
+        size_t size_cells = std::bit_ceil(std::max<size_t>(capacity, 2));
+
+        cells_ = std::make_unique<Cell[]>(size_cells);
+        mask_ = size_cells - 1;
+
+        for(size_t i = 0; i < size_cells; ++i){
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool BoundedIndexQueue::TryPush(int value){
+        size_t position = position_push_.load(std::memory_order_relaxed);
+
+        while(true){
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if(difference == 0){
+                if(position_push_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }else if(difference < 0){
+                return false;
+            }else{
+                position = position_push_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool BoundedIndexQueue::TryPop(int& value){
+        size_t position = position_pop_.load(std::memory_order_relaxed);
+
+        while(true){
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+            if(difference == 0){
+                if(position_pop_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    value = cell.value;
+                    cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }else if(difference < 0){
+                return false;
+            }else{
+                position = position_pop_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t BoundedIndexQueue::GetSize() const{
+        size_t position_push = position_push_.load(std::memory_order_acquire);
+        size_t position_pop = position_pop_.load(std::memory_order_acquire);
+        return (position_push > position_pop) ? position_push - position_pop : 0;
+    }
+
+}//namespace output_writer
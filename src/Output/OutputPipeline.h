@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace output_writer{
+
+    //Ограниченная lock-free очередь индексов (Д. Вьюков, bounded MPMC queue)
+    class BoundedIndexQueue{
+    public:
+        explicit BoundedIndexQueue(size_t capacity);
+
+        BoundedIndexQueue(const BoundedIndexQueue& other) = delete;
+        BoundedIndexQueue& operator=(const BoundedIndexQueue& other) = delete;
+
+        [[nodiscard]] bool TryPush(int value);
+        [[nodiscard]] bool TryPop(int& value);
+
+        size_t GetSize() const;
+
+        size_t GetCapacity() const{
+            return mask_ + 1;
+        }
+
+    private:
+        struct Cell{
+            std::atomic<size_t> sequence;
+            int value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+
+        alignas(64) std::atomic<size_t> position_push_{0};
+        alignas(64) std::atomic<size_t> position_pop_{0};
+    };
+
+    enum class Backpressure{
+        kBlock,         //Шаг ждёт, пока писатель освободит место
+        kDropOldest,    //Самый старый снимок в очереди отбрасывается
+        kCoalesce       //Новый снимок не ставится в очередь, следующий шаг перезапишет его и попробует снова
+    };
+
+    struct PipelineCounters{
+        size_t queue_depth = 0;
+        size_t max_queue_depth = 0;
+        size_t pushed = 0;
+        size_t written = 0;
+        size_t dropped = 0;
+        size_t coalesced = 0;
+        size_t blocked = 0;
+        //Снимки и сбросы по интервалу, которые писатель не смог поставить в очередь БД
+        size_t write_errors = 0;
+    };
+
+    //Передача снимков выходных сигналов фоновому писателю.
+    //Снимки лежат в заранее созданном пуле буферов и переиспользуются, очередь передаёт только их номера.
+    template<typename TypeSnapshot>
+    class OutputPipeline{
+    public:
+        using Consumer = std::function<void(TypeSnapshot& snapshot)>;
+        using Idle = std::function<void()>;
+
+        OutputPipeline(size_t capacity, Backpressure backpressure, Consumer consumer, Idle idle = {});
+        ~OutputPipeline();
+
+        OutputPipeline(const OutputPipeline& other) = delete;
+        OutputPipeline& operator=(const OutputPipeline& other) = delete;
+
+        //Буфер для заполнения очередного снимка. Действителен до Push.
+        TypeSnapshot& GetBufferToFill(){
+            return buffers_[fill_buffer_];
+        }
+
+        void Push();
+
+        //Ждёт, пока писатель обработает все снимки в очереди
+        void Drain();
+
+        PipelineCounters GetCounters() const;
+
+    private:
+        void WriterLoop();
+        void NotifyWriter();
+        void PushBuffer(Backpressure backpressure);
+
+        std::vector<TypeSnapshot> buffers_;
+        BoundedIndexQueue queue_ready_;
+        BoundedIndexQueue queue_free_;
+        int fill_buffer_ = -1;
+        bool has_coalesced_ = false;
+
+        Backpressure backpressure_;
+        Consumer consumer_;
+        Idle idle_;
+
+        std::atomic<size_t> count_pushed_{0};
+        std::atomic<size_t> count_written_{0};
+        std::atomic<size_t> count_dropped_{0};
+        std::atomic<size_t> count_coalesced_{0};
+        std::atomic<size_t> count_blocked_{0};
+        std::atomic<size_t> max_queue_depth_{0};
+
+        std::mutex mutex_wait_;
+        std::condition_variable cv_writer_;
+        std::condition_variable cv_producer_;
+        bool stop_ = false;
+
+        std::thread writer_;
+    };
+
+    template<typename TypeSnapshot>
+    OutputPipeline<TypeSnapshot>::OutputPipeline(size_t capacity, Backpressure backpressure, Consumer consumer, Idle idle)
+        :   queue_ready_(capacity),
+            queue_free_(queue_ready_.GetCapacity() + 2),
+            backpressure_(backpressure),
+            consumer_(std::move(consumer)),
+            idle_(std::move(idle))
+    {
+        //Кроме мест в очереди, один буфер заполняется шагом расчёта и один обрабатывается писателем
+        buffers_.resize(queue_ready_.GetCapacity() + 2);
+
+        fill_buffer_ = 0;
+        for(int buffer = 1; buffer < static_cast<int>(buffers_.size()); ++buffer){
+            (void)queue_free_.TryPush(buffer);
+        }
+
+        writer_ = std::thread(&OutputPipeline::WriterLoop, this);
+    }
+
+    template<typename TypeSnapshot>
+    OutputPipeline<TypeSnapshot>::~OutputPipeline(){
+        {
+            std::lock_guard lock(mutex_wait_);
+            stop_ = true;
+        }
+        cv_writer_.notify_all();
+        writer_.join();
+    }
+
+    template<typename TypeSnapshot>
+    void OutputPipeline<TypeSnapshot>::NotifyWriter(){
+        {
+            std::lock_guard lock(mutex_wait_);
+        }
+        cv_writer_.notify_one();
+    }
+
+    template<typename TypeSnapshot>
+    void OutputPipeline<TypeSnapshot>::Push(){
+        PushBuffer(backpressure_);
+    }
+
+    template<typename TypeSnapshot>
+    void OutputPipeline<TypeSnapshot>::PushBuffer(Backpressure backpressure){
+        while(!queue_ready_.TryPush(fill_buffer_)){
+            if(backpressure == Backpressure::kCoalesce){
+                count_coalesced_.fetch_add(1, std::memory_order_relaxed);
+                has_coalesced_ = true;
+                return;
+            }
+
+            if(backpressure == Backpressure::kDropOldest){
+                int oldest;
+                if(queue_ready_.TryPop(oldest)){
+                    count_dropped_.fetch_add(1, std::memory_order_relaxed);
+                    (void)queue_free_.TryPush(oldest);
+                }
+                continue;
+            }
+
+            count_blocked_.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock lock(mutex_wait_);
+            cv_producer_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+
+        count_pushed_.fetch_add(1, std::memory_order_relaxed);
+        has_coalesced_ = false;
+
+        size_t depth = queue_ready_.GetSize();
+        size_t max_depth = max_queue_depth_.load(std::memory_order_relaxed);
+        while(depth > max_depth && !max_queue_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)){}
+
+        NotifyWriter();
+
+        //Свободный буфер есть всегда, см. конструктор
+        while(!queue_free_.TryPop(fill_buffer_)){
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename TypeSnapshot>
+    void OutputPipeline<TypeSnapshot>::Drain(){
+        //Последний снимок, не попавший в очередь при kCoalesce, дописывается
+        if(has_coalesced_){
+            PushBuffer(Backpressure::kBlock);
+        }
+
+        while(queue_ready_.GetSize() != 0 || count_written_.load(std::memory_order_acquire) + count_dropped_.load(std::memory_order_acquire) < count_pushed_.load(std::memory_order_acquire)){
+            NotifyWriter();
+            std::unique_lock lock(mutex_wait_);
+            cv_producer_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    template<typename TypeSnapshot>
+    void OutputPipeline<TypeSnapshot>::WriterLoop(){
+        while(true){
+            int buffer;
+
+            if(queue_ready_.TryPop(buffer)){
+                consumer_(buffers_[buffer]);
+                (void)queue_free_.TryPush(buffer);
+                count_written_.fetch_add(1, std::memory_order_release);
+                cv_producer_.notify_all();
+                continue;
+            }
+
+            if(idle_){
+                idle_();
+            }
+
+            std::unique_lock lock(mutex_wait_);
+            if(stop_ && queue_ready_.GetSize() == 0){
+                return;
+            }
+            cv_writer_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    template<typename TypeSnapshot>
+    PipelineCounters OutputPipeline<TypeSnapshot>::GetCounters() const{
+        PipelineCounters counters;
+        counters.queue_depth = queue_ready_.GetSize();
+        counters.max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+        counters.pushed = count_pushed_.load(std::memory_order_relaxed);
+        counters.written = count_written_.load(std::memory_order_relaxed);
+        counters.dropped = count_dropped_.load(std::memory_order_relaxed);
+        counters.coalesced = count_coalesced_.load(std::memory_order_relaxed);
+        counters.blocked = count_blocked_.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+}//namespace output_writer
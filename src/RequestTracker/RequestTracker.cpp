@@ -0,0 +1,191 @@
+#include "RequestTracker.h"
+
+#include <algorithm>
+
+namespace request_tracker{
+
+    namespace{
+
+        const std::string kQueryMarker = "SELECT 1 AS request_tracker_marker";
+        const std::string kNameTableMarker = "request_tracker_marker";
+
+    }
+
+    ResultInsertRequest RequestHandle::Wait(std::chrono::milliseconds timeout) const{
+        if(!IsValid() || result.wait_for(timeout) != std::future_status::ready){
+            return {};
+        }
+
+        return result.get();
+    }
+
+    RequestTracker::RequestTracker(IDatabaseClient& db, std::chrono::microseconds min_poll, std::chrono::microseconds max_poll)
+        :   db_(db),
+            min_poll_(min_poll),
+            max_poll_(std::max(min_poll, max_poll))
+    {
+        completion_thread_ = std::thread(&RequestTracker::CompletionLoop, this);
+    }
+
+    RequestTracker::~RequestTracker(){
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        completion_thread_.join();
+    }
+
+    RequestHandle RequestTracker::Submit(   const std::string& name_connection,
+                                            const std::string& query,
+                                            std::vector<std::string> values,
+                                            Command command,
+                                            const std::string& name_table
+    ){
+        RequestHandle handle;
+        auto pending = std::make_unique<PendingRequest>();
+
+        {
+            //Запрос и метка ставятся подряд, между ними не попадёт запрос другого потока
+            std::lock_guard lock_db(mutex_db_);
+
+            auto result_insert = db_.InsertRequestInQueue(name_connection, query, std::move(values), command, name_table);
+
+            handle.result_request = result_insert.result_request;
+            handle.id_request = result_insert.id_request;
+
+            if(handle.result_request != ResultRequest::kInProcessing){
+                return handle;
+            }
+
+            if(command == Command::kInsert){
+                auto result_marker = db_.InsertRequestInQueue(name_connection, kQueryMarker, {}, Command::kSelect, kNameTableMarker);
+                if(result_marker.result_request == ResultRequest::kInProcessing){
+                    pending->id_marker = result_marker.id_request;
+                }
+            }
+        }
+
+        pending->id_request = handle.id_request;
+        pending->command = command;
+        handle.result = pending->promise.get_future().share();
+
+        {
+            //Результат остаётся в DatabaseManagements, пока его не заберут, регистрация после постановки его не теряет
+            std::lock_guard lock(mutex_);
+            pending_.push_back(std::move(pending));
+        }
+        cv_.notify_one();
+
+        return handle;
+    }
+
+    IDatabaseClient::QueueResult RequestTracker::Enqueue(   const std::string& name_connection,
+                                                            const std::string& query,
+                                                            std::vector<std::string> values,
+                                                            Command command,
+                                                            const std::string& name_table
+    ){
+        std::lock_guard lock(mutex_db_);
+        return db_.InsertRequestInQueue(name_connection, query, std::move(values), command, name_table);
+    }
+
+    bool RequestTracker::AreRequestsInProgress(){
+        std::lock_guard lock(mutex_db_);
+        return db_.AreRequestsInProgress();
+    }
+
+    size_t RequestTracker::GetCountPending() const{
+        std::lock_guard lock(mutex_);
+        return pending_.size();
+    }
+
+    bool RequestTracker::PollRequest(PendingRequest& pending, bool& queue_empty, bool& queue_checked){
+        std::lock_guard lock(mutex_db_);
+
+        if(pending.command == Command::kSelect){
+            ResultInsertRequest result = db_.GetResultSelectFromID(pending.id_request);
+            if(result.id_request == -1){
+                return false;
+            }
+
+            pending.promise.set_value(std::move(result));
+            return true;
+        }
+
+        bool completed = pending.id_marker != -1 && db_.GetResultSelectFromID(pending.id_marker).id_request != -1;
+
+        if(!completed){
+            if(!queue_checked){
+                queue_empty = !db_.AreRequestsInProgress();
+                queue_checked = true;
+            }
+
+            if(!queue_empty){
+                return false;
+            }
+
+            //Очередь пуста, метка выполнена, её результат больше не нужен
+            if(pending.id_marker != -1){
+                db_.GetResultSelectFromID(pending.id_marker);
+            }
+        }
+
+        ResultInsertRequest result;
+        result.id_request = pending.id_request;
+        pending.promise.set_value(std::move(result));
+
+        return true;
+    }
+
+    void RequestTracker::CompletionLoop(){
+        std::chrono::microseconds poll = min_poll_;
+        std::vector<PendingRequest*> polling;
+
+        std::unique_lock lock(mutex_);
+
+        while(true){
+            cv_.wait(lock, [this](){ return stop_ || !pending_.empty(); });
+
+            //При остановке незавершённые запросы получают пустой результат (id_request == -1)
+            if(stop_){
+                for(auto& pending : pending_){
+                    pending->promise.set_value({});
+                }
+                pending_.clear();
+                return;
+            }
+
+            //Объекты запросов не перемещаются при добавлении новых, опрос идёт без мьютекса списка
+            polling.clear();
+            for(auto& pending : pending_){
+                polling.push_back(pending.get());
+            }
+
+            lock.unlock();
+
+            bool completed = false;
+            bool queue_empty = false;
+            bool queue_checked = false;
+
+            for(PendingRequest* pending : polling){
+                if(PollRequest(*pending, queue_empty, queue_checked)){
+                    pending->completed = true;
+                    completed = true;
+                }
+            }
+
+            lock.lock();
+
+            std::erase_if(pending_, [](const auto& pending){ return pending->completed; });
+
+            //Пока запросы выполняются, интервал опроса растёт, после завершения снова минимальный
+            poll = (completed) ? min_poll_ : std::min(poll * 2, max_poll_);
+
+            if(!pending_.empty() && !stop_){
+                cv_.wait_for(lock, poll);
+            }
+        }
+    }
+
+}//namespace request_tracker
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DatabaseClient.h"
+
+namespace request_tracker{
+
+    using namespace database_client;
+
+    //Результат постановки запроса в очередь и ожидание именно этого запроса
+    struct RequestHandle{
+        ResultRequest result_request = ResultRequest::kError;
+        int id_request = -1;
+        std::shared_future<ResultInsertRequest> result;
+
+        bool IsValid() const{
+            return result_request == ResultRequest::kInProcessing && result.valid();
+        }
+
+        bool IsReady() const{
+            return IsValid() && result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        //Ждёт завершения не дольше timeout, при таймауте id_request результата -1
+        ResultInsertRequest Wait(std::chrono::milliseconds timeout) const;
+    };
+
+    //Отслеживает завершение поставленных в IDatabaseClient запросов в одном фоновом потоке
+    //и будит ожидающего сразу, как только готов его запрос.
+    //Все обращения к IDatabaseClient после подключения идут через трекер и выполняются по одному:
+    //DatabaseManagements не рассчитан на вызовы из нескольких потоков одновременно.
+    //DatabaseManagements не сообщает о готовности сам, поэтому поток опрашивает только ожидаемые id
+    //с интервалом от min_poll до max_poll: короткие запросы замечаются за десятки микросекунд.
+    //Опрос не держит мьютекс списка ожидаемых запросов, Submit не ждёт очередного опроса.
+    class RequestTracker{
+    public:
+        explicit RequestTracker(IDatabaseClient& db,
+                                std::chrono::microseconds min_poll = std::chrono::microseconds(50),
+                                std::chrono::microseconds max_poll = std::chrono::microseconds(2000));
+        ~RequestTracker();
+
+        RequestTracker(const RequestTracker& other) = delete;
+        RequestTracker& operator=(const RequestTracker& other) = delete;
+
+        //Для kSelect готовность - появление результата с id запроса.
+        //Для kInsert DatabaseManagements не выдаёт результат по id, поэтому сразу за ним в то же подключение
+        //ставится метка - SELECT без обращения к таблицам. Подключение выполняет запросы по порядку,
+        //и результат метки означает, что запрос выполнен. Запрос также считается выполненным,
+        //если очередь DatabaseManagements опустела, но под постоянной записью этого может не случиться.
+        RequestHandle Submit(   const std::string& name_connection,
+                                const std::string& query,
+                                std::vector<std::string> values,
+                                Command command,
+                                const std::string& name_table
+        );
+
+        //Постановка в очередь без ожидания результата (запись выходных сигналов)
+        IDatabaseClient::QueueResult Enqueue(   const std::string& name_connection,
+                                                const std::string& query,
+                                                std::vector<std::string> values,
+                                                Command command,
+                                                const std::string& name_table
+        );
+
+        bool AreRequestsInProgress();
+
+        size_t GetCountPending() const;
+
+    private:
+        struct PendingRequest{
+            int id_request;
+            Command command;
+            //Метка завершения kInsert, -1 - метку поставить не удалось
+            int id_marker = -1;
+            std::promise<ResultInsertRequest> promise;
+            bool completed = false;
+        };
+
+        //true - запрос выполнен, результат передан в promise
+        bool PollRequest(PendingRequest& pending, bool& queue_empty, bool& queue_checked);
+
+        void CompletionLoop();
+
+        IDatabaseClient& db_;
+        std::chrono::microseconds min_poll_;
+        std::chrono::microseconds max_poll_;
+
+        //Обращения к IDatabaseClient
+        std::mutex mutex_db_;
+
+        //Список ожидаемых запросов. Удаляет из него только поток завершения.
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::unique_ptr<PendingRequest>> pending_;
+        bool stop_ = false;
+
+        std::thread completion_thread_;
+    };
+
+}//namespace request_tracker
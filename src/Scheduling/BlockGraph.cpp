@@ -0,0 +1,132 @@
+#include "BlockGraph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace scheduling{
+
+    void BlockGraph::Clear(){
+        successors_.clear();
+        count_predecessors_.clear();
+    }
+
+    void BlockGraph::Build(const std::vector<std::vector<const void*>>& written_objects){
+        Clear();
+
+        size_t count_blocks = written_objects.size();
+        successors_.resize(count_blocks);
+        count_predecessors_.assign(count_blocks, 0);
+
+        std::unordered_map<const void*, int> last_writer;
+
+        for(int block = 0; block < static_cast<int>(count_blocks); ++block){
+            std::vector<int> predecessors;
+
+            for(const void* object : written_objects[block]){
+                auto [iter_writer, inserted] = last_writer.try_emplace(object, block);
+
+                if(!inserted){
+                    if(iter_writer->second != block){
+                        predecessors.push_back(iter_writer->second);
+                    }
+                    iter_writer->second = block;
+                }
+            }
+
+            std::sort(predecessors.begin(), predecessors.end());
+            predecessors.erase(std::unique(predecessors.begin(), predecessors.end()), predecessors.end());
+
+            for(int predecessor : predecessors){
+                successors_[predecessor].push_back(block);
+            }
+            count_predecessors_[block] = static_cast<int>(predecessors.size());
+        }
+    }
+
+    namespace{
+
+        struct RunState{
+            const BlockGraph* graph;
+            WorkStealingPool* pool;
+            const std::function<void(int)>* task;
+
+            std::unique_ptr<std::atomic<int>[]> count_wait;
+            std::atomic<int> count_remaining;
+            std::atomic<bool> failed{false};
+
+            std::mutex mutex_done;
+            std::condition_variable cv_done;
+            bool done = false;
+
+            std::mutex mutex_exception;
+            std::exception_ptr exception;
+        };
+
+        void RunBlock(RunState& state, int block){
+            if(!state.failed.load(std::memory_order_acquire)){
+                try{
+                    (*state.task)(block);
+                }catch(...){
+                    std::lock_guard lock(state.mutex_exception);
+                    if(!state.exception){
+                        state.exception = std::current_exception();
+                    }
+                    state.failed.store(true, std::memory_order_release);
+                }
+            }
+
+            for(int successor : state.graph->GetSuccessors(block)){
+                if(state.count_wait[successor].fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    state.pool->Submit([&state, successor]{ RunBlock(state, successor); });
+                }
+            }
+
+            if(state.count_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                std::lock_guard lock(state.mutex_done);
+                state.done = true;
+                state.cv_done.notify_all();
+            }
+        }
+
+    }
+
+    void BlockGraph::Run(WorkStealingPool& pool, const std::function<void(int)>& task) const{
+        int count_blocks = static_cast<int>(successors_.size());
+
+        if(count_blocks == 0){
+            return;
+        }
+
+        RunState state;
+        state.graph = this;
+        state.pool = &pool;
+        state.task = &task;
+        state.count_wait = std::make_unique<std::atomic<int>[]>(count_blocks);
+        state.count_remaining.store(count_blocks, std::memory_order_relaxed);
+
+        for(int block = 0; block < count_blocks; ++block){
+            state.count_wait[block].store(count_predecessors_[block], std::memory_order_relaxed);
+        }
+
+        for(int block = 0; block < count_blocks; ++block){
+            if(count_predecessors_[block] == 0){
+                pool.Submit([&state, block]{ RunBlock(state, block); });
+            }
+        }
+
+        {
+            std::unique_lock lock(state.mutex_done);
+            state.cv_done.wait(lock, [&state]{ return state.done; });
+        }
+
+        if(state.exception){
+            std::rethrow_exception(state.exception);
+        }
+    }
+
+}//namespace scheduling
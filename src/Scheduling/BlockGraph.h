@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace scheduling{
+
+    //Граф зависимостей блоков расчёта. Блоки, пишущие в один и тот же объект,
+    //выполняются в порядке загрузки, остальные не зависят друг от друга.
+    class BlockGraph{
+    public:
+        //written_objects[i] - объекты, которые изменяет блок i
+        void Build(const std::vector<std::vector<const void*>>& written_objects);
+        void Clear();
+
+        size_t GetCountBlocks() const{
+            return successors_.size();
+        }
+
+        const std::vector<int>& GetSuccessors(int block) const{
+            return successors_[block];
+        }
+
+        int GetCountPredecessors(int block) const{
+            return count_predecessors_[block];
+        }
+
+        //Выполняет task для каждого блока с соблюдением зависимостей.
+        //Исключение из task прекращает запуск оставшихся блоков и пробрасывается вызывающему.
+        void Run(WorkStealingPool& pool, const std::function<void(int)>& task) const;
+
+    private:
+        std::vector<std::vector<int>> successors_;
+        std::vector<int> count_predecessors_;
+    };
+
+}//namespace scheduling
@@ -0,0 +1,176 @@
+#include "StepScheduler.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace scheduling{
+
+    StepScheduler::~StepScheduler(){
+        Stop();
+    }
+
+    bool StepScheduler::Start(const Settings& settings, Step step){
+        Stop();
+
+        if(settings.period <= std::chrono::nanoseconds::zero() || !step){
+            return false;
+        }
+
+        settings_ = settings;
+        step_ = std::move(step);
+
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = false;
+            counters_ = {};
+        }
+
+        warning_thread_settings_.store(false, std::memory_order_release);
+        running_.store(true, std::memory_order_release);
+        thread_ = std::thread(&StepScheduler::Loop, this);
+
+        return true;
+    }
+
+    void StepScheduler::Stop(){
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        cv_stop_.notify_all();
+
+        if(thread_.joinable()){
+            thread_.join();
+        }
+
+        running_.store(false, std::memory_order_release);
+    }
+
+    StepScheduler::Counters StepScheduler::GetCounters() const{
+        std::lock_guard lock(mutex_);
+        return counters_;
+    }
+
+    #ifdef _WIN32
+
+    bool StepScheduler::ApplyThreadSettings(){
+        bool result = true;
+        HANDLE thread = ::GetCurrentThread();
+
+        if(settings_.cpu >= 0 && ::SetThreadAffinityMask(thread, DWORD_PTR(1) << settings_.cpu) == 0){
+            result = false;
+        }
+
+        if(settings_.fifo_priority > 0 && ::SetThreadPriority(thread, THREAD_PRIORITY_TIME_CRITICAL) == 0){
+            result = false;
+        }
+
+        return result;
+    }
+
+    #else
+
+    bool StepScheduler::ApplyThreadSettings(){
+        bool result = true;
+        pthread_t thread = ::pthread_self();
+
+        #ifdef __linux__
+            if(settings_.cpu >= 0){
+                cpu_set_t set_cpu;
+                CPU_ZERO(&set_cpu);
+                CPU_SET(settings_.cpu, &set_cpu);
+                if(::pthread_setaffinity_np(thread, sizeof(set_cpu), &set_cpu) != 0){
+                    result = false;
+                }
+            }
+        #else
+            if(settings_.cpu >= 0){
+                result = false;
+            }
+        #endif
+
+        if(settings_.fifo_priority > 0){
+            sched_param param{};
+            param.sched_priority = std::clamp(settings_.fifo_priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+            //Требует CAP_SYS_NICE или RLIMIT_RTPRIO
+            if(::pthread_setschedparam(thread, SCHED_FIFO, &param) != 0){
+                result = false;
+            }
+        }
+
+        return result;
+    }
+
+    #endif
+
+    void StepScheduler::Loop(){
+        if(!ApplyThreadSettings()){
+            warning_thread_settings_.store(true, std::memory_order_release);
+        }
+
+        const auto period = settings_.period;
+        const Clock::time_point start = Clock::now();
+        const auto start_system = std::chrono::system_clock::now();
+
+        size_t index = 0;
+
+        while(true){
+            Clock::time_point scheduled = start + period * index;
+
+            {
+                std::unique_lock lock(mutex_);
+                if(cv_stop_.wait_until(lock, scheduled, [this](){ return stop_; })){
+                    return;
+                }
+            }
+
+            Tick tick;
+            tick.index = index;
+            tick.scheduled = scheduled;
+            tick.scheduled_system = start_system + std::chrono::duration_cast<std::chrono::system_clock::duration>(scheduled - start);
+            tick.started = Clock::now();
+
+            bool success = step_(tick);
+
+            Clock::time_point finished = Clock::now();
+            auto jitter = tick.started - scheduled;
+            auto duration = finished - tick.started;
+
+            //Следующий срок по сетке; опоздавшие сроки пропускаются или выполняются подряд
+            size_t next = index + 1;
+            size_t due = static_cast<size_t>((finished - start) / period);
+            size_t skipped = 0;
+
+            if(due >= next){
+                size_t behind = due - next + 1;
+                size_t keep = (settings_.catch_up == CatchUp::kCompress) ? std::min(behind, settings_.max_catch_up) : 0;
+
+                skipped = behind - keep;
+                next += skipped;
+            }
+
+            {
+                std::lock_guard lock(mutex_);
+                ++counters_.steps;
+                if(!success){
+                    ++counters_.failed;
+                }
+                if(duration > period){
+                    ++counters_.overruns;
+                }
+                counters_.skipped += skipped;
+                counters_.max_jitter = std::max<std::chrono::nanoseconds>(counters_.max_jitter, jitter);
+                counters_.max_duration = std::max<std::chrono::nanoseconds>(counters_.max_duration, duration);
+            }
+
+            index = next;
+        }
+    }
+
+}//namespace scheduling
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace scheduling{
+
+    //Запуск шагов с постоянным периодом по монотонным часам в отдельном потоке.
+    //Срок каждого шага считается от момента запуска (start + index * period), поэтому ошибка не накапливается.
+    class StepScheduler{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class CatchUp{
+            kSkip,          //Пропущенные сроки отбрасываются, следующий шаг - в ближайший срок по сетке
+            kCompress       //Пропущенные шаги выполняются подряд без ожидания (не больше max_catch_up), остальные отбрасываются
+        };
+
+        struct Settings{
+            std::chrono::nanoseconds period{std::chrono::seconds(1)};
+            CatchUp catch_up = CatchUp::kSkip;
+            size_t max_catch_up = 10;
+
+            int cpu = -1;               //Номер ядра для потока шагов, -1 - без привязки
+            int fifo_priority = 0;      //Приоритет SCHED_FIFO (1-99), 0 - обычное планирование
+        };
+
+        struct Tick{
+            size_t index = 0;
+            Clock::time_point scheduled;                        //Срок шага
+            std::chrono::system_clock::time_point scheduled_system;   //Срок шага в системном времени
+            Clock::time_point started;
+        };
+
+        //false - шаг завершился ошибкой, расписание продолжается
+        using Step = std::function<bool(const Tick& tick)>;
+
+        struct Counters{
+            size_t steps = 0;
+            size_t failed = 0;
+            size_t overruns = 0;        //Шаг длился дольше периода
+            size_t skipped = 0;         //Сроки, для которых шаг не выполнялся
+            std::chrono::nanoseconds max_jitter{0};     //Наибольшее опоздание начала шага относительно срока
+            std::chrono::nanoseconds max_duration{0};
+        };
+
+        StepScheduler() = default;
+        ~StepScheduler();
+
+        StepScheduler(const StepScheduler& other) = delete;
+        StepScheduler& operator=(const StepScheduler& other) = delete;
+
+        //Если не удалось применить привязку к ядру или приоритет, поток всё равно запускается,
+        //а HasThreadSettingsWarning возвращает true
+        [[nodiscard]] bool Start(const Settings& settings, Step step);
+        void Stop();
+
+        bool IsRunning() const{
+            return running_.load(std::memory_order_acquire);
+        }
+
+        bool HasThreadSettingsWarning() const{
+            return warning_thread_settings_.load(std::memory_order_acquire);
+        }
+
+        Counters GetCounters() const;
+
+    private:
+        void Loop();
+        bool ApplyThreadSettings();
+
+        Settings settings_;
+        Step step_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable cv_stop_;
+        bool stop_ = false;
+        Counters counters_;
+
+        std::atomic<bool> running_{false};
+        std::atomic<bool> warning_thread_settings_{false};
+        std::thread thread_;
+    };
+
+}//namespace scheduling
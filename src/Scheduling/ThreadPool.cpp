@@ -0,0 +1,145 @@
+#include "ThreadPool.h"
+
+#include <exception>
+
+namespace scheduling{
+
+    namespace{
+        thread_local const WorkStealingPool* current_pool = nullptr;
+        thread_local size_t current_worker = 0;
+    }
+
+    WorkStealingPool::WorkStealingPool(size_t count_threads){
+        if(count_threads == 0){
+            count_threads = 1;
+        }
+
+        workers_.reserve(count_threads);
+        for(size_t i = 0; i < count_threads; ++i){
+            workers_.push_back(std::make_unique<Worker>());
+        }
+
+        threads_.reserve(count_threads);
+        for(size_t i = 0; i < count_threads; ++i){
+            threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool(){
+        {
+            std::lock_guard lock(mutex_wait_);
+            stop_ = true;
+        }
+        cv_wait_.notify_all();
+
+        for(auto& thread : threads_){
+            thread.join();
+        }
+    }
+
+    void WorkStealingPool::Submit(Task task){
+        size_t index_worker = (current_pool == this) ?
+                                current_worker :
+                                next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+        {
+            std::lock_guard lock(workers_[index_worker]->mutex);
+            workers_[index_worker]->tasks.push_back(std::move(task));
+        }
+
+        {
+            std::lock_guard lock(mutex_wait_);
+            count_pending_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cv_wait_.notify_one();
+    }
+
+    void WorkStealingPool::ForEach(size_t count, const std::function<void(size_t index)>& task){
+        std::mutex mutex_done;
+        std::condition_variable cv_done;
+        size_t count_remaining = count;
+        std::exception_ptr exception;
+
+        for(size_t index = 0; index < count; ++index){
+            Submit([&, index]{
+                std::exception_ptr exception_task;
+
+                try{
+                    task(index);
+                }catch(...){
+                    exception_task = std::current_exception();
+                }
+
+                //Счётчик меняется под мьютексом, иначе ожидающий поток может выйти и разрушить его раньше notify
+                std::lock_guard lock(mutex_done);
+                if(exception_task && !exception){
+                    exception = exception_task;
+                }
+                if(--count_remaining == 0){
+                    cv_done.notify_all();
+                }
+            });
+        }
+
+        {
+            std::unique_lock lock(mutex_done);
+            cv_done.wait(lock, [&count_remaining]{ return count_remaining == 0; });
+        }
+
+        if(exception){
+            std::rethrow_exception(exception);
+        }
+    }
+
+    bool WorkStealingPool::TryPop(size_t index_worker, Task& task){
+        Worker& worker = *workers_[index_worker];
+        std::lock_guard lock(worker.mutex);
+
+        if(worker.tasks.empty()){
+            return false;
+        }
+
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool WorkStealingPool::TrySteal(size_t index_worker, Task& task){
+        for(size_t shift = 1; shift < workers_.size(); ++shift){
+            Worker& victim = *workers_[(index_worker + shift) % workers_.size()];
+            std::lock_guard lock(victim.mutex);
+
+            if(!victim.tasks.empty()){
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void WorkStealingPool::WorkerLoop(size_t index_worker){
+        current_pool = this;
+        current_worker = index_worker;
+
+        Task task;
+
+        while(true){
+            if(TryPop(index_worker, task) || TrySteal(index_worker, task)){
+                count_pending_.fetch_sub(1, std::memory_order_relaxed);
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock lock(mutex_wait_);
+            cv_wait_.wait(lock, [this]{ return stop_ || count_pending_.load(std::memory_order_relaxed) > 0; });
+
+            if(stop_ && count_pending_.load(std::memory_order_relaxed) == 0){
+                return;
+            }
+        }
+    }
+
+}//namespace scheduling
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scheduling{
+
+    //Пул потоков с собственной очередью у каждого потока.
+    //Задача, поставленная из потока пула, попадает в его очередь и берётся им же с конца,
+    //свободные потоки забирают задачи из начала чужих очередей.
+    class WorkStealingPool{
+    public:
+        using Task = std::function<void()>;
+
+        explicit WorkStealingPool(size_t count_threads);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool& other) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool& other) = delete;
+
+        void Submit(Task task);
+
+        //Выполняет task(0) ... task(count - 1) в потоках пула и ждёт завершения всех.
+        //Первое исключение пробрасывается после завершения. Не вызывается из потока этого пула.
+        void ForEach(size_t count, const std::function<void(size_t index)>& task);
+
+        size_t GetCountThreads() const{
+            return workers_.size();
+        }
+
+    private:
+        struct Worker{
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void WorkerLoop(size_t index_worker);
+        bool TryPop(size_t index_worker, Task& task);
+        bool TrySteal(size_t index_worker, Task& task);
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+
+        std::atomic<size_t> next_worker_{0};
+        std::atomic<size_t> count_pending_{0};
+
+        std::mutex mutex_wait_;
+        std::condition_variable cv_wait_;
+        bool stop_ = false;
+    };
+
+}//namespace scheduling
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace signal_store{
+
+    //Номер объекта в хранилище. Выдаётся подряд при загрузке моделей и не меняется до Release или Clear.
+    struct SignalHandle{
+        static constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+
+        uint32_t id = kInvalid;
+
+        bool IsValid() const{
+            return id != kInvalid;
+        }
+    };
+
+    //Непрерывное хранилище сигналов одного вида.
+    //Объекты лежат блоками по kSizeChunk подряд в порядке создания, блоки не перемещаются,
+    //поэтому указатели, переданные в блоки расчёта, остаются действительными, а обход по номерам идёт по памяти подряд.
+    //Номера освобождённых объектов (например, сигналов старого набора после перезагрузки) выдаются Add повторно.
+    template<typename TypeSignal>
+    class SignalStore{
+    public:
+        static constexpr size_t kSizeChunk = 1024;
+
+        SignalStore() = default;
+
+        SignalStore(const SignalStore& other) = delete;
+        SignalStore& operator=(const SignalStore& other) = delete;
+
+        SignalHandle Add(){
+            if(!free_ids_.empty()){
+                uint32_t id = free_ids_.back();
+                free_ids_.pop_back();
+                is_free_[id] = false;
+                return {id};
+            }
+
+            if(size_ == chunks_.size() * kSizeChunk){
+                chunks_.push_back(std::make_unique<TypeSignal[]>(kSizeChunk));
+            }
+
+            is_free_.push_back(false);
+            return {static_cast<uint32_t>(size_++)};
+        }
+
+        //Объект сбрасывается в состояние по умолчанию, память остаётся в хранилище
+        void Release(SignalHandle handle){
+            if(is_free_[handle.id]){
+                return;
+            }
+
+            Get(handle) = TypeSignal{};
+            is_free_[handle.id] = true;
+            free_ids_.push_back(handle.id);
+        }
+
+        TypeSignal& Get(SignalHandle handle){
+            return chunks_[handle.id / kSizeChunk][handle.id % kSizeChunk];
+        }
+
+        const TypeSignal& Get(SignalHandle handle) const{
+            return chunks_[handle.id / kSizeChunk][handle.id % kSizeChunk];
+        }
+
+        //Число занятых объектов
+        size_t GetSize() const{
+            return size_ - free_ids_.size();
+        }
+
+        void Clear(){
+            chunks_.clear();
+            free_ids_.clear();
+            is_free_.clear();
+            size_ = 0;
+        }
+
+        //Обход занятых объектов в порядке номеров
+        template<typename Function>
+        void ForEach(Function&& function){
+            for(size_t id = 0; id < size_; ++id){
+                if(is_free_[id]){
+                    continue;
+                }
+                function(SignalHandle{static_cast<uint32_t>(id)}, chunks_[id / kSizeChunk][id % kSizeChunk]);
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<TypeSignal[]>> chunks_;
+        std::vector<uint32_t> free_ids_;
+        std::vector<bool> is_free_;
+        size_t size_ = 0;
+    };
+
+}//namespace signal_store
@@ -0,0 +1,90 @@
+//Тестовый поставщик данных для режима CalcServer::InputMode::kSharedMemory.
+//
+//  SharedMemoryTestProducer <имя сегмента> <файл со списком KKS> [период, мс] [число шагов]
+//
+//Файл со списком содержит по одному KKS в строке. Каждый период во все слоты
+//записывается синусоида со своим сдвигом фазы, чётные слоты получают double, нечётные int.
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SharedMemoryProducer.h"
+
+namespace{
+    volatile std::sig_atomic_t need_stop = 0;
+
+    void StopProducer(int){
+        need_stop = 1;
+    }
+}
+
+int main(int argc, char* argv[]){
+    using namespace input_signals::shared_memory;
+
+    if(argc < 3){
+        std::cerr << "Usage: " << argv[0] << " <name segment> <file with KKS> [period ms] [count steps]" << std::endl;
+        return 1;
+    }
+
+    std::string name_segment = argv[1];
+    std::ifstream file_kks(argv[2]);
+
+    if(!file_kks.is_open()){
+        std::cerr << "It is not possible to open a file with the name: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> list_kks;
+    for(std::string kks; std::getline(file_kks, kks);){
+        if(!kks.empty() && kks.back() == '\r'){
+            kks.pop_back();
+        }
+        if(!kks.empty()){
+            list_kks.push_back(std::move(kks));
+        }
+    }
+
+    auto period = std::chrono::milliseconds((argc > 3) ? std::stoi(argv[3]) : 1000);
+    long long count_steps = (argc > 4) ? std::stoll(argv[4]) : -1;
+
+    SharedMemoryProducer producer;
+    if(!producer.Create(name_segment, list_kks)){
+        std::cerr << "It is not possible to create a shared memory segment: " << name_segment << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, StopProducer);
+    std::signal(SIGTERM, StopProducer);
+
+    std::cout << "Segment " << name_segment << " created, KKS: " << list_kks.size() << std::endl;
+
+    auto next_write = std::chrono::steady_clock::now();
+
+    for(long long step = 0; !need_stop && step != count_steps; ++step){
+        producer.BeginWrite();
+
+        for(int slot = 0; slot < static_cast<int>(list_kks.size()); ++slot){
+            double value = std::sin(0.1 * static_cast<double>(step) + slot);
+            if(slot % 2 == 0){
+                producer.SetValue(slot, value);
+            }else{
+                producer.SetValue(slot, static_cast<int>(value * 100));
+            }
+        }
+
+        producer.EndWrite();
+
+        next_write += period;
+        std::this_thread::sleep_until(next_write);
+    }
+
+    producer.Close(true);
+
+    return 0;
+}